@@ -0,0 +1,111 @@
+#include "pch.h"
+#include "AssetLoader.h"
+
+namespace dae
+{
+	AssetLoader::AssetLoader(uint32_t threadCount)
+	{
+		const uint32_t workerCount{ std::max(threadCount, 1u) };
+
+		m_Workers.reserve(workerCount);
+		for (uint32_t index{ 0 }; index < workerCount; ++index)
+		{
+			m_Workers.emplace_back(&AssetLoader::WorkerLoop, this);
+		}
+	}
+
+	AssetLoader::~AssetLoader()
+	{
+		//Jobs that are loading finish, queued ones never start
+		{
+			std::lock_guard<std::mutex> lock{ m_Mutex };
+			m_IsStopping = true;
+			m_QueuedJobs.clear();
+		}
+		m_WakeCondition.notify_all();
+
+		for (std::thread& worker : m_Workers)
+		{
+			worker.join();
+		}
+
+		for (const LoadedJob& job : m_LoadedJobs)
+		{
+			job.discard();
+		}
+	}
+
+	size_t AssetLoader::PublishReady()
+	{
+		//Published outside the lock, a ready callback can queue more jobs
+		std::vector<LoadedJob> loadedJobs{};
+		{
+			std::lock_guard<std::mutex> lock{ m_Mutex };
+			loadedJobs.swap(m_LoadedJobs);
+		}
+
+		for (const LoadedJob& job : loadedJobs)
+		{
+			job.publish();
+		}
+		return loadedJobs.size();
+	}
+
+	void AssetLoader::PublishAll()
+	{
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock{ m_Mutex };
+				m_LoadedCondition.wait(lock, [this]() { return !m_LoadedJobs.empty() || (m_QueuedJobs.empty() && m_LoadingCount == 0); });
+			}
+
+			//Nothing left once there was nothing to publish, ready callbacks that queue more jobs keep the loop going
+			if (PublishReady() == 0)
+				return;
+		}
+	}
+
+	bool AssetLoader::IsIdle() const
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		return m_QueuedJobs.empty() && m_LoadingCount == 0 && m_LoadedJobs.empty();
+	}
+
+	void AssetLoader::Enqueue(std::function<LoadedJob()> job)
+	{
+		{
+			std::lock_guard<std::mutex> lock{ m_Mutex };
+			m_QueuedJobs.push_back(std::move(job));
+		}
+		m_WakeCondition.notify_one();
+	}
+
+	void AssetLoader::WorkerLoop()
+	{
+		while (true)
+		{
+			std::function<LoadedJob()> job{};
+			{
+				std::unique_lock<std::mutex> lock{ m_Mutex };
+				m_WakeCondition.wait(lock, [this]() { return m_IsStopping || !m_QueuedJobs.empty(); });
+
+				if (m_IsStopping)
+					return;
+
+				job = std::move(m_QueuedJobs.front());
+				m_QueuedJobs.pop_front();
+				++m_LoadingCount;
+			}
+
+			LoadedJob loadedJob{ job() };
+
+			{
+				std::lock_guard<std::mutex> lock{ m_Mutex };
+				m_LoadedJobs.push_back(std::move(loadedJob));
+				--m_LoadingCount;
+			}
+			m_LoadedCondition.notify_all();
+		}
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dae
+{
+	//Loads assets on its own worker threads & hands them back on the thread that publishes them
+	//Loading never waits on rendering or the other way around, the renderer keeps drawing placeholders until an asset is published
+	class AssetLoader final
+	{
+	public:
+		explicit AssetLoader(uint32_t threadCount = GetDefaultThreadCount());
+		~AssetLoader();
+
+		AssetLoader(const AssetLoader&) = delete;
+		AssetLoader(AssetLoader&&) noexcept = delete;
+		AssetLoader& operator=(const AssetLoader&) = delete;
+		AssetLoader& operator=(AssetLoader&&) noexcept = delete;
+
+		//Runs load on a worker, ready gets its result during the next PublishReady & owns it from then on
+		//load may return nullptr when it fails, ready is called either way so it can keep its placeholder
+		//Assets that are loaded but never published are deleted with the loader
+		template<typename Asset>
+		void Load(std::function<Asset*()> load, std::function<void(Asset*)> ready)
+		{
+			Enqueue([load{ std::move(load) }, ready{ std::move(ready) }]()
+				{
+					Asset* pAsset{ load() };
+					return LoadedJob{ [pAsset, ready]() { ready(pAsset); }, [pAsset]() { delete pAsset; } };
+				});
+		}
+
+		//Calls the ready callback of every job that finished since the last call, in the order they finished
+		//Returns how many were published
+		size_t PublishReady();
+
+		//Blocks until every job is loaded & publishes them, for runs that have to start with every asset in
+		void PublishAll();
+
+		//Nothing queued, loading or waiting to be published
+		bool IsIdle() const;
+
+	private:
+		//Leaves the cores of the render thread pool some room while loading
+		static uint32_t GetDefaultThreadCount()
+		{
+			return std::max(std::thread::hardware_concurrency() / 2, 1u);
+		}
+
+		struct LoadedJob
+		{
+			std::function<void()> publish{};
+			std::function<void()> discard{};
+		};
+
+		void Enqueue(std::function<LoadedJob()> job);
+		void WorkerLoop();
+
+		std::vector<std::thread> m_Workers{};
+
+		mutable std::mutex m_Mutex{};
+		std::condition_variable m_WakeCondition{};
+		std::condition_variable m_LoadedCondition{};
+
+		std::deque<std::function<LoadedJob()>> m_QueuedJobs{};
+		std::vector<LoadedJob> m_LoadedJobs{};
+		uint32_t m_LoadingCount{};
+		bool m_IsStopping{ false };
+	};
+}
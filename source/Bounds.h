@@ -0,0 +1,144 @@
+#pragma once
+#include "Math.h"
+
+namespace dae
+{
+	//Axis aligned box & a sphere around the same points, a mesh gets them once when it's loaded
+	struct Bounds
+	{
+		Vector3 min{ FLT_MAX, FLT_MAX, FLT_MAX };
+		Vector3 max{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		Vector3 center{};
+		float radius{};
+
+		bool IsEmpty() const
+		{
+			return min.x > max.x;
+		}
+
+		//Only grows the box, the sphere is set up once all points are in
+		void Grow(const Vector3& point)
+		{
+			min = { std::min(min.x, point.x), std::min(min.y, point.y), std::min(min.z, point.z) };
+			max = { std::max(max.x, point.x), std::max(max.y, point.y), std::max(max.z, point.z) };
+		}
+		void Grow(const Bounds& other)
+		{
+			//An empty box has min & max swapped at +-FLT_MAX, growing by them would make this one infinite
+			if (other.IsEmpty())
+				return;
+
+			Grow(other.min);
+			Grow(other.max);
+		}
+
+		//Box around the transformed box (every new extent is the absolute matrix times the old one), the sphere scales with the longest axis
+		Bounds Transformed(const Matrix& matrix) const
+		{
+			if (IsEmpty())
+				return *this;
+
+			const Vector3 axes[3]{ matrix.GetAxisX(), matrix.GetAxisY(), matrix.GetAxisZ() };
+			const Vector3 extent{ (max - min) * 0.5f };
+			const Vector3 boxCenter{ matrix.TransformPoint((min + max) * 0.5f) };
+
+			Vector3 transformedExtent{};
+			for (int axis{ 0 }; axis < 3; ++axis)
+			{
+				transformedExtent[axis] = fabsf(axes[0][axis]) * extent.x + fabsf(axes[1][axis]) * extent.y + fabsf(axes[2][axis]) * extent.z;
+			}
+
+			Bounds transformed{};
+			transformed.min = boxCenter - transformedExtent;
+			transformed.max = boxCenter + transformedExtent;
+			transformed.center = matrix.TransformPoint(center);
+			transformed.radius = radius * sqrtf(std::max(axes[0].SqrMagnitude(), std::max(axes[1].SqrMagnitude(), axes[2].SqrMagnitude())));
+			return transformed;
+		}
+	};
+
+	//World space planes of a view frustum, xyz is the normal pointing inwards & w the distance: inside where Dot(normal, p) + w >= 0
+	struct Frustum
+	{
+		static constexpr int PLANE_COUNT{ 6 };
+		static constexpr uint32_t ALL_PLANES{ (1u << PLANE_COUNT) - 1 };
+
+		Vector4 planes[PLANE_COUNT]{};
+
+		//Row vectors are multiplied with the matrix, so clip x, y, z & w are dot products with its columns
+		//Left, right, bottom & top are w +- x & w +- y, near is z >= 0 (D3D depth) & far is w - z
+		static Frustum FromViewProjection(const Matrix& viewProjection)
+		{
+			Vector4 columns[4]{};
+			for (int column{ 0 }; column < 4; ++column)
+			{
+				columns[column] = { viewProjection[0][column], viewProjection[1][column], viewProjection[2][column], viewProjection[3][column] };
+			}
+
+			Frustum frustum{};
+			frustum.planes[0] = columns[3] + columns[0];
+			frustum.planes[1] = columns[3] - columns[0];
+			frustum.planes[2] = columns[3] + columns[1];
+			frustum.planes[3] = columns[3] - columns[1];
+			frustum.planes[4] = columns[2];
+			frustum.planes[5] = columns[3] - columns[2];
+
+			//Unit normals, so sphere tests can compare against the radius
+			for (Vector4& plane : frustum.planes)
+			{
+				plane = plane * (1.f / sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z));
+			}
+			return frustum;
+		}
+
+		//Same frustum in the space the matrix transforms from, so object space volumes can be tested without transforming them
+		//A point p maps to p * matrix, so every plane becomes the matrix times the plane as a column
+		Frustum Transformed(const Matrix& matrix) const
+		{
+			Frustum transformed{};
+			for (int index{ 0 }; index < PLANE_COUNT; ++index)
+			{
+				Vector4& plane{ transformed.planes[index] };
+				plane = { Vector4::Dot(matrix[0], planes[index]), Vector4::Dot(matrix[1], planes[index]), Vector4::Dot(matrix[2], planes[index]), Vector4::Dot(matrix[3], planes[index]) };
+				plane = plane * (1.f / sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z));
+			}
+			return transformed;
+		}
+
+		bool IntersectsSphere(const Vector3& sphereCenter, float sphereRadius) const
+		{
+			for (const Vector4& plane : planes)
+			{
+				if (plane.x * sphereCenter.x + plane.y * sphereCenter.y + plane.z * sphereCenter.z + plane.w < -sphereRadius)
+					return false;
+			}
+			return true;
+		}
+
+		//False when the box is entirely outside one of the planes
+		//insideMask gets a bit for every plane the box is entirely inside of, planes already set in it aren't tested again
+		//so a hierarchy can pass it down & skip the planes a parent box was already inside of
+		bool IntersectsBox(const Vector3& boxMin, const Vector3& boxMax, uint32_t& insideMask) const
+		{
+			for (int index{ 0 }; index < PLANE_COUNT; ++index)
+			{
+				const uint32_t planeBit{ 1u << index };
+				if (insideMask & planeBit)
+					continue;
+
+				//Corners furthest along & against the normal
+				const Vector4& plane{ planes[index] };
+				const float maxDistance{ plane.x * (plane.x > 0.f ? boxMax.x : boxMin.x) + plane.y * (plane.y > 0.f ? boxMax.y : boxMin.y) + plane.z * (plane.z > 0.f ? boxMax.z : boxMin.z) + plane.w };
+				if (maxDistance < 0.f)
+					return false;
+
+				const float minDistance{ plane.x * (plane.x > 0.f ? boxMin.x : boxMax.x) + plane.y * (plane.y > 0.f ? boxMin.y : boxMax.y) + plane.z * (plane.z > 0.f ? boxMin.z : boxMax.z) + plane.w };
+				if (minDistance >= 0.f)
+				{
+					insideMask |= planeBit;
+				}
+			}
+			return true;
+		}
+	};
+}
@@ -0,0 +1,154 @@
+#include "pch.h"
+#include "Bvh.h"
+
+namespace dae
+{
+	void Bvh::Build(const std::vector<Bounds>& itemBounds)
+	{
+		m_Nodes.clear();
+		m_Items.resize(itemBounds.size());
+		for (uint32_t item{ 0 }; item < m_Items.size(); ++item)
+		{
+			m_Items[item] = item;
+		}
+
+		if (m_Items.empty())
+			return;
+
+		//A binary tree with leaves of at least one item never needs more than 2n - 1 nodes
+		m_Nodes.reserve(2 * m_Items.size());
+		m_Nodes.emplace_back();
+		BuildNode(0, 0, static_cast<uint32_t>(m_Items.size()), itemBounds);
+	}
+
+	void Bvh::BuildNode(uint32_t nodeIndex, uint32_t begin, uint32_t end, const std::vector<Bounds>& itemBounds)
+	{
+		{
+			Node& node{ m_Nodes[nodeIndex] };
+			node.first = begin;
+			node.count = end - begin;
+			FitNode(node, itemBounds);
+
+			if (node.count <= MAX_LEAF_SIZE)
+				return;
+		}
+
+		//Longest axis of the box around the item centers
+		Bounds centerBounds{};
+		for (uint32_t index{ begin }; index < end; ++index)
+		{
+			const Bounds& bounds{ itemBounds[m_Items[index]] };
+			centerBounds.Grow((bounds.min + bounds.max) * 0.5f);
+		}
+
+		const Vector3 extent{ centerBounds.max - centerBounds.min };
+		int axis{ 0 };
+		if (extent.y > extent[axis])
+			axis = 1;
+		if (extent.z > extent[axis])
+			axis = 2;
+
+		//Median split, both halves get the same number of items so the depth stays log(n)
+		const uint32_t middle{ begin + (end - begin) / 2 };
+		std::nth_element(m_Items.begin() + begin, m_Items.begin() + middle, m_Items.begin() + end, [&](uint32_t left, uint32_t right)
+			{
+				return itemBounds[left].min[axis] + itemBounds[left].max[axis] < itemBounds[right].min[axis] + itemBounds[right].max[axis];
+			});
+
+		//Emplacing can reallocate, so the node is looked up again instead of kept as a reference
+		const uint32_t firstChild{ static_cast<uint32_t>(m_Nodes.size()) };
+		m_Nodes.emplace_back();
+		m_Nodes.emplace_back();
+		m_Nodes[nodeIndex].first = firstChild;
+		m_Nodes[nodeIndex].count = 0;
+
+		BuildNode(firstChild, begin, middle, itemBounds);
+		BuildNode(firstChild + 1, middle, end, itemBounds);
+	}
+
+	void Bvh::FitNode(Node& node, const std::vector<Bounds>& itemBounds) const
+	{
+		Bounds nodeBounds{};
+		if (node.count > 0)
+		{
+			for (uint32_t index{ node.first }; index < node.first + node.count; ++index)
+			{
+				nodeBounds.Grow(itemBounds[m_Items[index]]);
+			}
+		}
+		else
+		{
+			for (uint32_t child{ node.first }; child < node.first + 2; ++child)
+			{
+				//As a box, so a child with only empty items stays empty instead of growing its parent to infinity
+				nodeBounds.Grow(Bounds{ m_Nodes[child].min, m_Nodes[child].max });
+			}
+		}
+
+		node.min = nodeBounds.min;
+		node.max = nodeBounds.max;
+	}
+
+	void Bvh::Refit(const std::vector<Bounds>& itemBounds)
+	{
+		//Children are always created after their parent, walking backwards visits them first
+		for (size_t index{ m_Nodes.size() }; index-- > 0;)
+		{
+			FitNode(m_Nodes[index], itemBounds);
+		}
+	}
+
+	void Bvh::Cull(const Frustum& frustum, const std::vector<Bounds>& itemBounds, std::vector<uint32_t>& visibleItems) const
+	{
+		if (m_Nodes.empty())
+			return;
+
+		struct StackEntry
+		{
+			uint32_t nodeIndex{};
+			uint32_t insideMask{};
+		};
+
+		//Median splits keep the tree balanced, 64 levels are far more than any item count needs
+		StackEntry stack[64]{};
+		int stackSize{ 0 };
+		stack[stackSize++] = { 0, 0 };
+
+		while (stackSize > 0)
+		{
+			const StackEntry entry{ stack[--stackSize] };
+			const Node& node{ m_Nodes[entry.nodeIndex] };
+
+			uint32_t insideMask{ entry.insideMask };
+			if (!frustum.IntersectsBox(node.min, node.max, insideMask))
+				continue;
+
+			if (node.count == 0)
+			{
+				stack[stackSize++] = { node.first, insideMask };
+				stack[stackSize++] = { node.first + 1, insideMask };
+				continue;
+			}
+
+			for (uint32_t index{ node.first }; index < node.first + node.count; ++index)
+			{
+				const uint32_t item{ m_Items[index] };
+
+				//Entirely inside the frustum, nothing left to test
+				if (insideMask == Frustum::ALL_PLANES)
+				{
+					visibleItems.push_back(item);
+					continue;
+				}
+
+				//The sphere is the cheaper test, the box is tighter for what the sphere lets through
+				const Bounds& bounds{ itemBounds[item] };
+				uint32_t itemInsideMask{ insideMask };
+				if (frustum.IntersectsSphere(bounds.center, bounds.radius) && frustum.IntersectsBox(bounds.min, bounds.max, itemInsideMask))
+				{
+					visibleItems.push_back(item);
+				}
+			}
+		}
+	}
+}
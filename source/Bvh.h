@@ -0,0 +1,47 @@
+#pragma once
+#include "Bounds.h"
+
+#include <vector>
+
+namespace dae
+{
+	//Bounding volume hierarchy over the world bounds of a set of items (the software renderer's instances)
+	//Built top down by splitting at the median centroid along the longest axis, culled against a Frustum
+	class Bvh final
+	{
+	public:
+		Bvh() = default;
+
+		void Build(const std::vector<Bounds>& itemBounds);
+
+		//Keeps the tree & only recomputes the node boxes, for items that moved but didn't get added or removed
+		void Refit(const std::vector<Bounds>& itemBounds);
+
+		//Appends the items whose bounds intersect the frustum, whole subtrees get accepted or rejected at once
+		void Cull(const Frustum& frustum, const std::vector<Bounds>& itemBounds, std::vector<uint32_t>& visibleItems) const;
+
+		size_t GetItemCount() const
+		{
+			return m_Items.size();
+		}
+
+	private:
+		static constexpr uint32_t MAX_LEAF_SIZE{ 4 };
+
+		struct Node
+		{
+			Vector3 min{};
+			Vector3 max{};
+
+			//Leaves cover m_Items[first, first + count), inner nodes have count 0 & their children at first & first + 1
+			uint32_t first{};
+			uint32_t count{};
+		};
+
+		std::vector<Node> m_Nodes{};
+		std::vector<uint32_t> m_Items{};
+
+		void BuildNode(uint32_t nodeIndex, uint32_t begin, uint32_t end, const std::vector<Bounds>& itemBounds);
+		void FitNode(Node& node, const std::vector<Bounds>& itemBounds) const;
+	};
+}
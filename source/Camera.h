@@ -4,6 +4,7 @@
 #include <SDL_mouse.h>
 
 #include "Math.h"
+#include "Bounds.h"
 #include "Timer.h"
 #include <algorithm>
 
@@ -40,6 +41,9 @@ namespace dae
 		Matrix viewMatrix{};
 		Matrix projectionMatrix{};
 
+		//World space, follows the matrices
+		Frustum frustum{};
+
 		void Initialize(float _fovAngle = 90.f, Vector3 _origin = {0.f,0.f,0.f}, float _aspectRatio = 1.f)
 		{
 			fovAngle = _fovAngle;
@@ -88,6 +92,19 @@ namespace dae
 			return GetViewMatrix() * GetProjectionMatrix();
 		}
 
+		//Height of a sphere's projection as a share of the screen height, the same in every direction so turning the camera doesn't change it
+		//FLT_MAX when the camera is inside the sphere
+		float GetScreenSize(const Vector3& center, float radius) const
+		{
+			const float squaredDistance{ (center - origin).SqrMagnitude() };
+			const float squaredRadius{ radius * radius };
+			if (squaredDistance <= squaredRadius)
+				return FLT_MAX;
+
+			//The tangent of the sphere's half angle over the one of the field of view
+			return radius / (sqrtf(squaredDistance - squaredRadius) * fov);
+		}
+
 		void Update(const Timer* pTimer)
 		{
 			const float deltaTime = pTimer->GetElapsed();
@@ -144,6 +161,21 @@ namespace dae
 
 			origin += directionVector;
 
+			CalculateMatrices();
+		}
+
+		//Places the camera without any input, used by the headless renderer (pitch & yaw in degrees)
+		void SetTransform(const Vector3& _origin, float pitch, float yaw)
+		{
+			origin = _origin;
+			totalPitch = std::clamp(pitch * TO_RADIANS, -89.f * TO_RADIANS, 89.0f * TO_RADIANS);
+			totalYaw = yaw * TO_RADIANS;
+
+			CalculateMatrices();
+		}
+
+		void CalculateMatrices()
+		{
 			Matrix rotationMatrix = Matrix::CreateRotationX(totalPitch) * Matrix::CreateRotationY(totalYaw);
 
 			forward = rotationMatrix.TransformVector(Vector3::UnitZ);
@@ -151,6 +183,8 @@ namespace dae
 			//Update Matrices
 			CalculateViewMatrix();
 			CalculateProjectionMatrix(); //Try to optimize this - should only be called once or when fov/aspectRatio changes
+
+			frustum = Frustum::FromViewProjection(viewMatrix * projectionMatrix);
 		}
 	};
 }
@@ -0,0 +1,93 @@
+#pragma once
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Math.h"
+
+namespace dae
+{
+	struct CameraKey
+	{
+		int frame{};
+		Vector3 origin{};
+		float pitch{};	//degrees
+		float yaw{};	//degrees
+	};
+
+	//Camera path for the headless renderer
+	//One key per line: frame originX originY originZ pitch yaw, lines starting with '#' are ignored
+	//Frames between two keys are linearly interpolated
+	class CameraScript final
+	{
+	public:
+		bool LoadFromFile(const std::string& filename)
+		{
+			std::ifstream file(filename);
+			if (!file)
+				return false;
+
+			m_Keys.clear();
+
+			std::string line;
+			while (std::getline(file, line))
+			{
+				if (line.empty() || line[0] == '#')
+					continue;
+
+				std::istringstream lineStream(line);
+
+				CameraKey key{};
+				if (lineStream >> key.frame >> key.origin.x >> key.origin.y >> key.origin.z >> key.pitch >> key.yaw)
+				{
+					m_Keys.push_back(key);
+				}
+			}
+
+			std::sort(m_Keys.begin(), m_Keys.end(), [](const CameraKey& a, const CameraKey& b) { return a.frame < b.frame; });
+			return !m_Keys.empty();
+		}
+
+		bool IsEmpty() const
+		{
+			return m_Keys.empty();
+		}
+
+		int GetLastFrame() const
+		{
+			return m_Keys.empty() ? 0 : m_Keys.back().frame;
+		}
+
+		CameraKey Evaluate(int frame) const
+		{
+			if (m_Keys.empty())
+				return CameraKey{ frame };
+
+			if (frame <= m_Keys.front().frame)
+				return m_Keys.front();
+
+			for (size_t index{ 1 }; index < m_Keys.size(); ++index)
+			{
+				const CameraKey& previous{ m_Keys[index - 1] };
+				const CameraKey& next{ m_Keys[index] };
+
+				if (frame > next.frame)
+					continue;
+
+				const float factor{ static_cast<float>(frame - previous.frame) / static_cast<float>(std::max(next.frame - previous.frame, 1)) };
+
+				CameraKey key{ frame };
+				key.origin = previous.origin + (next.origin - previous.origin) * factor;
+				key.pitch = Lerpf(previous.pitch, next.pitch, factor);
+				key.yaw = Lerpf(previous.yaw, next.yaw, factor);
+				return key;
+			}
+
+			return m_Keys.back();
+		}
+
+	private:
+		std::vector<CameraKey> m_Keys{};
+	};
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "Math.h"
+#include "Bounds.h"
 
 namespace dae
 {
@@ -22,6 +23,136 @@ namespace dae
 		Vector3 normal{};
 		Vector3 tangent{};
 		Vector3 viewDirection{};
+		Vector3 worldPosition{};
+
+		//Change of uv per pixel step along screen x & y, selects the mip level
+		Vector2 uvDerivativeX{};
+		Vector2 uvDerivativeY{};
+	};
+
+	//Deferred G-buffer entry, only what shading can't rebuild from the depth buffer & the pixel's position
+	//Normal & tangent are stored as 16 bit snorm, 36 bytes in total
+	struct GBufferTexel
+	{
+		Vector2 uv{};
+		Vector2 uvDerivativeX{};
+		Vector2 uvDerivativeY{};
+		int16_t normal[3]{};
+		int16_t tangent[3]{};
+
+		//The direction has to be normalized, truncating costs less than half a step of precision
+		static void PackDirection(const Vector3& direction, int16_t packed[3])
+		{
+			packed[0] = static_cast<int16_t>(direction.x * 32767.f);
+			packed[1] = static_cast<int16_t>(direction.y * 32767.f);
+			packed[2] = static_cast<int16_t>(direction.z * 32767.f);
+		}
+		static Vector3 UnpackDirection(const int16_t packed[3])
+		{
+			const Vector3 direction{ static_cast<float>(packed[0]), static_cast<float>(packed[1]), static_cast<float>(packed[2]) };
+			return direction * (1.f / std::sqrt(std::max(direction.SqrMagnitude(), FLT_MIN)));
+		}
+	};
+
+	//Vertex arrays are padded to a multiple of the widest SIMD register, so batches never need a scalar tail
+	constexpr size_t VERTEX_STREAM_PADDING{ 8 };
+
+	//Structure of arrays copy of the mesh vertices, one array per component so Simd::WIDTH vertices load at once
+	struct VertexStream
+	{
+		std::vector<float> positionX{};
+		std::vector<float> positionY{};
+		std::vector<float> positionZ{};
+		std::vector<float> u{};
+		std::vector<float> v{};
+		std::vector<float> normalX{};
+		std::vector<float> normalY{};
+		std::vector<float> normalZ{};
+		std::vector<float> tangentX{};
+		std::vector<float> tangentY{};
+		std::vector<float> tangentZ{};
+	};
+
+	//Transformed vertices, same layout as VertexStream
+	struct VertexStream_Out
+	{
+		//x & y in screen space (pixels), z is the NDC depth, w the view space depth used for perspective correct interpolation
+		std::vector<float> positionX{};
+		std::vector<float> positionY{};
+		std::vector<float> positionZ{};
+		std::vector<float> positionW{};
+		std::vector<float> normalX{};
+		std::vector<float> normalY{};
+		std::vector<float> normalZ{};
+		std::vector<float> tangentX{};
+		std::vector<float> tangentY{};
+		std::vector<float> tangentZ{};
+		std::vector<float> viewDirectionX{};
+		std::vector<float> viewDirectionY{};
+		std::vector<float> viewDirectionZ{};
+		std::vector<float> worldPositionX{};
+		std::vector<float> worldPositionY{};
+		std::vector<float> worldPositionZ{};
+
+		//Clip space outcode of every vertex, see Renderer::CLIP_LEFT & co.
+		std::vector<uint16_t> clipFlags{};
+	};
+
+	enum class LightType
+	{
+		Directional,
+		Point,
+		Spot
+	};
+
+	//Light of the software shader, in world space
+	struct Light
+	{
+		LightType type{ LightType::Directional };
+		Vector3 position{};		//Point & spot
+		Vector3 direction{};	//Directional & spot, normalized, the way the light travels
+		ColorRGB color{ colors::White };
+		float intensity{ 1.f };
+
+		//Point & spot: inverse square falloff, windowed to reach zero at range so lights can be culled past it
+		float range{};
+
+		//Spot: full intensity inside the inner cone, fading out towards the outer one
+		float cosInnerCone{};
+		float cosOuterCone{};
+	};
+
+	//Texture filtering, shared by the software sampler & the DirectX effects
+	//DirectX textures have no mip levels, so BILINEAR & TRILINEAR both use its linear technique
+	enum class FilteringMethod
+	{
+		POINT,
+		BILINEAR,
+		TRILINEAR,
+		ANISOTROPIC
+	};
+
+	//Which winding is dropped, shared by the software rasterizer & the DirectX effects
+	enum class CullMode
+	{
+		Off,
+		Front,
+		Back
+	};
+
+	//When the software rasterizer shades a fragment
+	enum class ShadingPipeline
+	{
+		Forward,			//As soon as it passes the depth test
+		Deferred,			//Once per visible pixel, after every triangle wrote its attributes to the G-buffer
+		VisibilityBuffer	//Once per visible pixel, attributes are fetched again from the triangle id the raster pass stored
+	};
+
+	//How the software rasterizer evaluates the specular power
+	enum class SpecularPrecision
+	{
+		Exact,	//powf
+		Fast	//LightingUtils::FastPow, within LightingUtils::FAST_POW_MAX_ERROR of powf
 	};
 
 	enum class PrimitiveTopology
@@ -30,15 +161,125 @@ namespace dae
 		TriangleStrip
 	};
 
+	//Run of up to MAX_VERTICES vertices & MAX_TRIANGLES triangles, contiguous in Mesh::indices & culled as a whole before binning
+	struct Meshlet
+	{
+		static constexpr uint32_t MAX_VERTICES{ 64 };
+		static constexpr uint32_t MAX_TRIANGLES{ 124 };
+
+		uint32_t firstIndex{};
+		uint32_t triangleCount{};
+
+		//Range of the vertex indices it uses, vertices are stored in first use order so there's little else in between
+		uint32_t vertexBegin{};
+		uint32_t vertexEnd{};
+
+		//Object space sphere around the meshlet's vertices
+		Vector3 center{};
+		float radius{};
+
+		//Normal cone: every triangle faces away from a viewpoint for which Dot(Normalize(coneApex - viewpoint), coneAxis) >= coneCutoff
+		Vector3 coneApex{};
+		Vector3 coneAxis{};
+		float coneCutoff{};
+	};
+
+	//One level of detail inside a mesh's vertex & index arrays, level 0 is the full mesh
+	//Every level has its own copy of the vertices it keeps, so its vertex range stays as compact as the full mesh's
+	struct MeshLod
+	{
+		static constexpr uint32_t MAX_COUNT{ 4 };
+
+		//Share of the full mesh's triangles every level is simplified towards
+		static constexpr float TRIANGLE_RATIOS[MAX_COUNT]{ 1.f, 0.5f, 0.25f, 0.1f };
+
+		//Level lod is drawn while the mesh covers at least MIN_SCREEN_SIZES[lod] of the screen height (Camera::GetScreenSize), the last one below all of them
+		static constexpr float MIN_SCREEN_SIZES[MAX_COUNT - 1]{ 0.5f, 0.25f, 0.12f };
+
+		//A mesh only goes back to a finer level once it covers this much more than the level's threshold,
+		//so one sitting right at a threshold doesn't pop between two levels every frame
+		static constexpr float FINER_HYSTERESIS{ 1.1f };
+
+		//Indices are absolute, they already point into this level's vertices
+		uint32_t firstIndex{};
+		uint32_t indexCount{};
+		uint32_t firstVertex{};
+		uint32_t vertexCount{};
+
+		//previousLod is the level the mesh was drawn with last frame
+		static uint32_t Select(float screenSize, uint32_t lodCount, uint32_t previousLod = 0)
+		{
+			if (lodCount == 0)
+				return 0;
+
+			uint32_t lod{ std::min(previousLod, lodCount - 1) };
+			while (lod + 1 < lodCount && screenSize < MIN_SCREEN_SIZES[lod])
+			{
+				++lod;
+			}
+			while (lod > 0 && screenSize >= MIN_SCREEN_SIZES[lod - 1] * FINER_HYSTERESIS)
+			{
+				--lod;
+			}
+			return lod;
+		}
+	};
+
 	struct Mesh
 	{
 		std::vector<Vertex> vertices{};
 		std::vector<uint32_t> indices{};
 		PrimitiveTopology primitiveTopology{ PrimitiveTopology::TriangleList };
 
-		std::vector<Vertex_Out> vertices_out{};
+		VertexStream vertexStream{};
+
+		//Object space, instances transform it to cull against the camera
+		Bounds bounds{};
+
+		//Triangle lists only, split up at load time
+		std::vector<Meshlet> meshlets{};
+
+		//Empty when the mesh has no simplified levels, otherwise meshlets[lodMeshletOffsets[lod] .. lodMeshletOffsets[lod + 1]] belong to lods[lod]
+		std::vector<MeshLod> lods{};
+		std::vector<uint32_t> lodMeshletOffsets{};
+
+		//Fills vertexStream from vertices, call again whenever the vertices change
+		void BuildVertexStream()
+		{
+			const size_t paddedCount{ (vertices.size() + VERTEX_STREAM_PADDING - 1) / VERTEX_STREAM_PADDING * VERTEX_STREAM_PADDING };
+
+			for (std::vector<float>* pComponent : { &vertexStream.positionX, &vertexStream.positionY, &vertexStream.positionZ, &vertexStream.u, &vertexStream.v,
+				&vertexStream.normalX, &vertexStream.normalY, &vertexStream.normalZ, &vertexStream.tangentX, &vertexStream.tangentY, &vertexStream.tangentZ })
+			{
+				pComponent->assign(paddedCount, 0.f);
+			}
+
+			for (size_t index{ 0 }; index < vertices.size(); ++index)
+			{
+				const Vertex& vertex{ vertices[index] };
+				vertexStream.positionX[index] = vertex.position.x;
+				vertexStream.positionY[index] = vertex.position.y;
+				vertexStream.positionZ[index] = vertex.position.z;
+				vertexStream.u[index] = vertex.uv.x;
+				vertexStream.v[index] = vertex.uv.y;
+				vertexStream.normalX[index] = vertex.normal.x;
+				vertexStream.normalY[index] = vertex.normal.y;
+				vertexStream.normalZ[index] = vertex.normal.z;
+				vertexStream.tangentX[index] = vertex.tangent.x;
+				vertexStream.tangentY[index] = vertex.tangent.y;
+				vertexStream.tangentZ[index] = vertex.tangent.z;
+			}
+		}
+	};
+
+	//Placement of a shared Mesh, the geometry is stored once no matter how many instances use it
+	struct MeshInstance
+	{
+		uint32_t meshIndex{};
 		Matrix worldMatrix{};
 
+		//Level of detail it was last drawn with, MeshLod::Select needs it for its hysteresis
+		uint32_t lod{};
 
 		void RotateY(float angle)
 		{
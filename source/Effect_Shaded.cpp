@@ -1,4 +1,6 @@
 #include "pch.h"
+
+#if !defined(SOFTWARE_ONLY)
 #include "Effect_Shaded.h"
 
 Effect_Shaded::Effect_Shaded(ID3D11Device* pDevice, const std::wstring& assetFile)
@@ -76,4 +78,5 @@ void Effect_Shaded::SetGlossinessMap(DirectX_Texture* pTexture)
 {
 	if (m_pGlossinessMapVariable)
 		m_pGlossinessMapVariable->SetResource(pTexture->GetShaderResourceView());
-}
\ No newline at end of file
+}
+#endif
@@ -0,0 +1,248 @@
+#include "pch.h"
+#include "MeshCache.h"
+#include "Utils.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+
+#include <filesystem>
+#include <map>
+#include <mutex>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dae
+{
+	static_assert(std::is_trivially_copyable_v<Vertex>, "Vertex is written to & mapped from the cache as raw bytes");
+
+	MeshCache::~MeshCache()
+	{
+		Unmap();
+	}
+
+	//One per cache file, never removed so the references stay valid
+	static std::mutex& GetCacheMutex(const std::string& cachePath)
+	{
+		static std::mutex mapMutex{};
+		static std::map<std::string, std::mutex> cacheMutexes{};
+
+		std::lock_guard<std::mutex> lock{ mapMutex };
+		return cacheMutexes[cachePath];
+	}
+
+	MeshCache* MeshCache::Load(const std::string& objPath, bool flipAxisAndWinding, bool buildLods)
+	{
+		const std::string cachePath{ objPath + ".bin" };
+
+		//Loads of the same file wait for each other, only the first one writes the cache & the rest map it
+		std::lock_guard<std::mutex> cacheLock{ GetCacheMutex(cachePath) };
+
+		Header header{};
+		const uint32_t flags{ (flipAxisAndWinding ? FLIP_AXIS_AND_WINDING_FLAG : 0) | (buildLods ? LODS_FLAG : 0) };
+		if (!ReadSourceInfo(objPath, flags, header))
+			return nullptr;
+
+		MeshCache* pCache{ new MeshCache{} };
+		if (pCache->Map(cachePath, header))
+			return pCache;
+
+		//Missing or stale, parse & optimize the OBJ once and write the cache for the next load
+		if (!Utils::ParseOBJ(objPath, pCache->m_ParsedVertices, pCache->m_ParsedIndices, header.bounds, flipAxisAndWinding))
+		{
+			delete pCache;
+			return nullptr;
+		}
+
+		MeshOptimizer::Optimize(pCache->m_ParsedVertices, pCache->m_ParsedIndices);
+
+		if (buildLods)
+		{
+			MeshSimplifier::BuildLodChain(pCache->m_ParsedVertices, pCache->m_ParsedIndices, pCache->m_ParsedLods);
+		}
+		else
+		{
+			pCache->m_ParsedLods = { { 0, static_cast<uint32_t>(pCache->m_ParsedIndices.size()), 0, static_cast<uint32_t>(pCache->m_ParsedVertices.size()) } };
+		}
+		header.lodCount = static_cast<uint32_t>(pCache->m_ParsedLods.size());
+		std::copy(pCache->m_ParsedLods.begin(), pCache->m_ParsedLods.end(), header.lods);
+
+		header.vertexCount = static_cast<uint32_t>(pCache->m_ParsedVertices.size());
+		header.indexCount = static_cast<uint32_t>(pCache->m_ParsedIndices.size());
+
+		if (Write(cachePath, header, pCache->m_ParsedVertices, pCache->m_ParsedIndices) && pCache->Map(cachePath, header))
+		{
+			pCache->m_ParsedVertices = {};
+			pCache->m_ParsedIndices = {};
+			pCache->m_ParsedLods = {};
+			return pCache;
+		}
+
+		std::cout << "Failed to write mesh cache: " << cachePath << '\n';
+		pCache->m_pVertices = pCache->m_ParsedVertices.data();
+		pCache->m_VertexCount = header.vertexCount;
+		pCache->m_pIndices = pCache->m_ParsedIndices.data();
+		pCache->m_IndexCount = header.indexCount;
+		pCache->m_Bounds = header.bounds;
+		pCache->m_Lods = pCache->m_ParsedLods.data();
+		pCache->m_LodCount = header.lodCount;
+		return pCache;
+	}
+
+	bool MeshCache::ReadSourceInfo(const std::string& objPath, uint32_t flags, Header& header)
+	{
+		std::error_code error{};
+		const auto sourceSize{ std::filesystem::file_size(objPath, error) };
+		if (error)
+			return false;
+
+		const auto sourceWriteTime{ std::filesystem::last_write_time(objPath, error) };
+		if (error)
+			return false;
+
+		header.version = VERSION;
+		header.vertexSize = sizeof(Vertex);
+		header.flags = flags;
+		header.sourceSize = static_cast<int64_t>(sourceSize);
+		header.sourceWriteTime = static_cast<int64_t>(sourceWriteTime.time_since_epoch().count());
+		return true;
+	}
+
+	bool MeshCache::Write(const std::string& cachePath, const Header& header, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+	{
+		std::ofstream file{ cachePath, std::ios::binary | std::ios::trunc };
+		if (!file)
+			return false;
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		file.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(Vertex));
+		file.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(uint32_t));
+
+		return static_cast<bool>(file);
+	}
+
+	bool MeshCache::Map(const std::string& cachePath, const Header& expectedHeader)
+	{
+		Unmap();
+
+#if defined(_WIN32)
+		m_FileHandle = CreateFileA(cachePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (m_FileHandle == INVALID_HANDLE_VALUE)
+		{
+			m_FileHandle = nullptr;
+			return false;
+		}
+
+		LARGE_INTEGER fileSize{};
+		if (!GetFileSizeEx(m_FileHandle, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(Header)))
+		{
+			Unmap();
+			return false;
+		}
+		m_MappedSize = static_cast<size_t>(fileSize.QuadPart);
+
+		m_MappingHandle = CreateFileMappingA(m_FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_MappingHandle)
+		{
+			m_pMappedData = MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0);
+		}
+#else
+		const int fileDescriptor{ open(cachePath.c_str(), O_RDONLY) };
+		if (fileDescriptor < 0)
+			return false;
+
+		struct stat fileStats {};
+		if (fstat(fileDescriptor, &fileStats) == 0 && fileStats.st_size >= static_cast<off_t>(sizeof(Header)))
+		{
+			m_MappedSize = static_cast<size_t>(fileStats.st_size);
+
+			void* pMappedData{ mmap(nullptr, m_MappedSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0) };
+			m_pMappedData = pMappedData != MAP_FAILED ? pMappedData : nullptr;
+		}
+
+		//The mapping stays valid after the descriptor is closed
+		close(fileDescriptor);
+#endif
+
+		if (!m_pMappedData)
+		{
+			Unmap();
+			return false;
+		}
+
+		const Header& header{ *static_cast<const Header*>(m_pMappedData) };
+		const size_t expectedSize{ sizeof(Header) + header.vertexCount * sizeof(Vertex) + header.indexCount * sizeof(uint32_t) };
+
+		const bool isValid
+		{
+			std::equal(std::begin(header.magic), std::end(header.magic), std::begin(expectedHeader.magic)) &&
+			header.version == expectedHeader.version &&
+			header.vertexSize == expectedHeader.vertexSize &&
+			header.flags == expectedHeader.flags &&
+			header.sourceSize == expectedHeader.sourceSize &&
+			header.sourceWriteTime == expectedHeader.sourceWriteTime &&
+			header.lodCount >= 1 && header.lodCount <= MeshLod::MAX_COUNT &&
+			m_MappedSize == expectedSize
+		};
+
+		if (!isValid)
+		{
+			Unmap();
+			return false;
+		}
+
+		const char* pData{ static_cast<const char*>(m_pMappedData) + sizeof(Header) };
+		m_pVertices = reinterpret_cast<const Vertex*>(pData);
+		m_VertexCount = header.vertexCount;
+		m_pIndices = reinterpret_cast<const uint32_t*>(pData + header.vertexCount * sizeof(Vertex));
+		m_IndexCount = header.indexCount;
+		m_Bounds = header.bounds;
+		m_Lods = header.lods;
+		m_LodCount = header.lodCount;
+
+		return true;
+	}
+
+	void MeshCache::Unmap()
+	{
+#if defined(_WIN32)
+		if (m_pMappedData)
+		{
+			UnmapViewOfFile(m_pMappedData);
+		}
+
+		if (m_MappingHandle)
+		{
+			CloseHandle(m_MappingHandle);
+			m_MappingHandle = nullptr;
+		}
+
+		if (m_FileHandle)
+		{
+			CloseHandle(m_FileHandle);
+			m_FileHandle = nullptr;
+		}
+#else
+		if (m_pMappedData)
+		{
+			munmap(m_pMappedData, m_MappedSize);
+		}
+#endif
+
+		m_pMappedData = nullptr;
+		m_MappedSize = 0;
+
+		m_pVertices = nullptr;
+		m_VertexCount = 0;
+		m_pIndices = nullptr;
+		m_IndexCount = 0;
+		m_Bounds = {};
+		m_Lods = nullptr;
+		m_LodCount = 0;
+	}
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include "DataTypes.h"
+
+namespace dae
+{
+	//Binary copy of a parsed & optimized OBJ, stored next to it as "<file>.bin" and memory mapped on later loads
+	//Layout: Header, vertexCount * Vertex, indexCount * uint32_t, the levels of detail in the header point into both
+	class MeshCache final
+	{
+	public:
+		~MeshCache();
+
+		MeshCache(const MeshCache&) = delete;
+		MeshCache(MeshCache&&) noexcept = delete;
+		MeshCache& operator=(const MeshCache&) = delete;
+		MeshCache& operator=(MeshCache&&) noexcept = delete;
+
+		//Maps the cache of objPath, parsing the OBJ and (re)writing the cache first when it is missing or out of date
+		//buildLods adds the simplified levels of MeshLod::TRIANGLE_RATIOS behind the full mesh, without it there's only level 0
+		//Returns nullptr when the OBJ can't be parsed, safe to call from several threads at once
+		static MeshCache* Load(const std::string& objPath, bool flipAxisAndWinding = true, bool buildLods = false);
+
+		const Vertex* GetVertices() const
+		{
+			return m_pVertices;
+		}
+		uint32_t GetVertexCount() const
+		{
+			return m_VertexCount;
+		}
+		const uint32_t* GetIndices() const
+		{
+			return m_pIndices;
+		}
+		uint32_t GetIndexCount() const
+		{
+			return m_IndexCount;
+		}
+		const Bounds& GetBounds() const
+		{
+			return m_Bounds;
+		}
+		const MeshLod* GetLods() const
+		{
+			return m_Lods;
+		}
+		uint32_t GetLodCount() const
+		{
+			return m_LodCount;
+		}
+
+	private:
+		struct Header
+		{
+			char magic[4]{ 'D', 'M', 'S', 'H' };
+			uint32_t version{};
+			uint32_t vertexSize{};
+			uint32_t flags{};
+
+			//Source OBJ at the time the cache was written, a mismatch means the cache is stale
+			int64_t sourceSize{};
+			int64_t sourceWriteTime{};
+
+			uint32_t vertexCount{};
+			uint32_t indexCount{};
+
+			//Computed by the parser, stored so a mapped cache doesn't have to walk the vertices again
+			Bounds bounds{};
+
+			uint32_t lodCount{};
+			MeshLod lods[MeshLod::MAX_COUNT]{};
+		};
+		static constexpr uint32_t VERSION{ 6 };
+
+		//Header::flags
+		static constexpr uint32_t FLIP_AXIS_AND_WINDING_FLAG{ 1 << 0 };
+		static constexpr uint32_t LODS_FLAG{ 1 << 1 };
+
+		MeshCache() = default;
+
+		static bool ReadSourceInfo(const std::string& objPath, uint32_t flags, Header& header);
+		static bool Write(const std::string& cachePath, const Header& header, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+		bool Map(const std::string& cachePath, const Header& expectedHeader);
+		void Unmap();
+
+		const Vertex* m_pVertices{ nullptr };
+		uint32_t m_VertexCount{};
+		const uint32_t* m_pIndices{ nullptr };
+		uint32_t m_IndexCount{};
+		Bounds m_Bounds{};
+		const MeshLod* m_Lods{ nullptr };
+		uint32_t m_LodCount{};
+
+		//Mapped file, or the parsed data itself when the cache couldn't be written
+		void* m_pMappedData{ nullptr };
+		size_t m_MappedSize{};
+#if defined(_WIN32)
+		void* m_FileHandle{ nullptr };
+		void* m_MappingHandle{ nullptr };
+#endif
+		std::vector<Vertex> m_ParsedVertices{};
+		std::vector<uint32_t> m_ParsedIndices{};
+		std::vector<MeshLod> m_ParsedLods{};
+	};
+}
@@ -0,0 +1,538 @@
+#include "pch.h"
+#include "MeshOptimizer.h"
+
+namespace dae
+{
+	namespace MeshOptimizer
+	{
+		//Scoring constants from the original article
+		constexpr float CACHE_DECAY_POWER{ 1.5f };
+		constexpr float LAST_TRIANGLE_SCORE{ 0.75f };
+		constexpr float VALENCE_BOOST_SCALE{ 2.0f };
+		constexpr float VALENCE_BOOST_POWER{ 0.5f };
+
+		//How many new meshlet vertices a triangle facing 90 degrees away from the meshlet is worth
+		constexpr float NORMAL_WEIGHT{ 2.0f };
+
+		static float GetVertexScore(int cachePosition, uint32_t remainingTriangles)
+		{
+			//Nothing left to draw with this vertex, it shouldn't pull any triangle forward
+			if (remainingTriangles == 0)
+				return -1.f;
+
+			float score{};
+			if (cachePosition >= 0)
+			{
+				//The last triangle's vertices get a fixed score so the next triangle doesn't just reuse the same edge
+				if (cachePosition < 3)
+				{
+					score = LAST_TRIANGLE_SCORE;
+				}
+				else
+				{
+					const float scaler{ 1.f / (CACHE_SIZE - 3) };
+					score = powf(1.f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+				}
+			}
+
+			//Vertices with few triangles left get a boost, so lone triangles get finished instead of left behind
+			score += VALENCE_BOOST_SCALE * powf(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+			return score;
+		}
+
+		float CalculateACMR(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+		{
+			const size_t triangleCount{ indices.size() / 3 };
+			if (triangleCount == 0)
+				return 0.f;
+
+			//Timestamp of when a vertex entered the FIFO, it's still in there while fewer than cacheSize misses happened since
+			std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+			uint32_t timestamp{ cacheSize + 1 };
+			uint32_t misses{};
+
+			for (const uint32_t index : indices)
+			{
+				if (timestamp - cacheTimestamps[index] > cacheSize)
+				{
+					cacheTimestamps[index] = timestamp++;
+					++misses;
+				}
+			}
+
+			return static_cast<float>(misses) / triangleCount;
+		}
+
+		void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount)
+		{
+			const size_t triangleCount{ indices.size() / 3 };
+			if (triangleCount == 0)
+				return;
+
+			//Triangles using every vertex, packed per vertex: vertexTriangles[vertexOffsets[v] .. + remainingTriangles[v]]
+			std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+			for (const uint32_t index : indices)
+			{
+				++remainingTriangles[index];
+			}
+
+			std::vector<uint32_t> vertexOffsets(vertexCount, 0);
+			for (size_t vertex{ 1 }; vertex < vertexCount; ++vertex)
+			{
+				vertexOffsets[vertex] = vertexOffsets[vertex - 1] + remainingTriangles[vertex - 1];
+			}
+
+			std::vector<uint32_t> vertexTriangles(indices.size());
+			std::vector<uint32_t> vertexFill(vertexCount, 0);
+			for (size_t triangle{ 0 }; triangle < triangleCount; ++triangle)
+			{
+				for (size_t corner{ 0 }; corner < 3; ++corner)
+				{
+					const uint32_t vertex{ indices[triangle * 3 + corner] };
+					vertexTriangles[vertexOffsets[vertex] + vertexFill[vertex]++] = static_cast<uint32_t>(triangle);
+				}
+			}
+
+			std::vector<float> vertexScores(vertexCount);
+			for (size_t vertex{ 0 }; vertex < vertexCount; ++vertex)
+			{
+				vertexScores[vertex] = GetVertexScore(-1, remainingTriangles[vertex]);
+			}
+
+			std::vector<float> triangleScores(triangleCount);
+			std::vector<bool> isTriangleEmitted(triangleCount, false);
+			int bestTriangle{ -1 };
+			float bestScore{ -FLT_MAX };
+			for (size_t triangle{ 0 }; triangle < triangleCount; ++triangle)
+			{
+				triangleScores[triangle] = vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+				if (triangleScores[triangle] > bestScore)
+				{
+					bestScore = triangleScores[triangle];
+					bestTriangle = static_cast<int>(triangle);
+				}
+			}
+
+			std::vector<uint32_t> optimizedIndices{};
+			optimizedIndices.reserve(indices.size());
+
+			//Simulated LRU cache, 3 extra slots for the vertices a new triangle pushes in before the old ones fall out
+			std::vector<uint32_t> cache{};
+			std::vector<uint32_t> newCache{};
+			cache.reserve(CACHE_SIZE + 3);
+			newCache.reserve(CACHE_SIZE + 3);
+
+			size_t nextInputTriangle{ 0 };
+			for (size_t emitted{ 0 }; emitted < triangleCount; ++emitted)
+			{
+				//No candidate in the cache, continue with the next triangle in input order
+				if (bestTriangle < 0)
+				{
+					while (isTriangleEmitted[nextInputTriangle])
+					{
+						++nextInputTriangle;
+					}
+					bestTriangle = static_cast<int>(nextInputTriangle);
+				}
+
+				const uint32_t* pTriangle{ &indices[bestTriangle * 3] };
+				isTriangleEmitted[bestTriangle] = true;
+
+				newCache.clear();
+				for (size_t corner{ 0 }; corner < 3; ++corner)
+				{
+					const uint32_t vertex{ pTriangle[corner] };
+					optimizedIndices.push_back(vertex);
+					newCache.push_back(vertex);
+
+					//Drop the triangle from the vertex's remaining list
+					uint32_t* pBegin{ &vertexTriangles[vertexOffsets[vertex]] };
+					uint32_t* pEnd{ pBegin + remainingTriangles[vertex] };
+					std::iter_swap(std::find(pBegin, pEnd, static_cast<uint32_t>(bestTriangle)), pEnd - 1);
+					--remainingTriangles[vertex];
+				}
+
+				for (const uint32_t vertex : cache)
+				{
+					if (vertex != pTriangle[0] && vertex != pTriangle[1] && vertex != pTriangle[2])
+					{
+						newCache.push_back(vertex);
+					}
+				}
+				std::swap(cache, newCache);
+
+				//Rescore everything that was in the cache, including the vertices that just fell out
+				bestTriangle = -1;
+				bestScore = -FLT_MAX;
+				for (size_t position{ 0 }; position < cache.size(); ++position)
+				{
+					const uint32_t vertex{ cache[position] };
+					const int cachePosition{ position < CACHE_SIZE ? static_cast<int>(position) : -1 };
+
+					const float score{ GetVertexScore(cachePosition, remainingTriangles[vertex]) };
+					const float scoreDelta{ score - vertexScores[vertex] };
+					vertexScores[vertex] = score;
+
+					const uint32_t* pBegin{ &vertexTriangles[vertexOffsets[vertex]] };
+					for (const uint32_t* pAdjacent{ pBegin }; pAdjacent < pBegin + remainingTriangles[vertex]; ++pAdjacent)
+					{
+						float& triangleScore{ triangleScores[*pAdjacent] };
+						triangleScore += scoreDelta;
+
+						if (cachePosition >= 0 && triangleScore > bestScore)
+						{
+							bestScore = triangleScore;
+							bestTriangle = static_cast<int>(*pAdjacent);
+						}
+					}
+				}
+
+				if (cache.size() > CACHE_SIZE)
+				{
+					cache.resize(CACHE_SIZE);
+				}
+			}
+
+			indices = std::move(optimizedIndices);
+		}
+
+		void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+		{
+			constexpr uint32_t UNUSED{ UINT32_MAX };
+			std::vector<uint32_t> remap(vertices.size(), UNUSED);
+
+			std::vector<Vertex> optimizedVertices{};
+			optimizedVertices.reserve(vertices.size());
+
+			for (uint32_t& index : indices)
+			{
+				if (remap[index] == UNUSED)
+				{
+					remap[index] = static_cast<uint32_t>(optimizedVertices.size());
+					optimizedVertices.push_back(vertices[index]);
+				}
+				index = remap[index];
+			}
+
+			for (size_t vertex{ 0 }; vertex < vertices.size(); ++vertex)
+			{
+				if (remap[vertex] == UNUSED)
+				{
+					optimizedVertices.push_back(vertices[vertex]);
+				}
+			}
+
+			vertices = std::move(optimizedVertices);
+		}
+
+		void WeldPositions(const std::vector<Vertex>& vertices, std::vector<uint32_t>& positionIds)
+		{
+			const size_t vertexCount{ vertices.size() };
+
+			//Sorting puts equal positions next to each other, the first one of every run becomes the id of the run
+			std::vector<uint32_t> sortedVertices(vertexCount);
+			for (uint32_t vertex{ 0 }; vertex < vertexCount; ++vertex)
+			{
+				sortedVertices[vertex] = vertex;
+			}
+			std::sort(sortedVertices.begin(), sortedVertices.end(), [&](uint32_t left, uint32_t right)
+				{
+					const Vector3& leftPosition{ vertices[left].position };
+					const Vector3& rightPosition{ vertices[right].position };
+					if (leftPosition.x != rightPosition.x)
+						return leftPosition.x < rightPosition.x;
+					if (leftPosition.y != rightPosition.y)
+						return leftPosition.y < rightPosition.y;
+					return leftPosition.z < rightPosition.z;
+				});
+
+			positionIds.resize(vertexCount);
+			for (size_t index{ 0 }; index < vertexCount; ++index)
+			{
+				const uint32_t vertex{ sortedVertices[index] };
+				const Vector3& position{ vertices[vertex].position };
+				bool isSamePosition{ false };
+				if (index > 0)
+				{
+					const Vector3& previousPosition{ vertices[sortedVertices[index - 1]].position };
+					isSamePosition = previousPosition.x == position.x && previousPosition.y == position.y && previousPosition.z == position.z;
+				}
+				positionIds[vertex] = isSamePosition ? positionIds[sortedVertices[index - 1]] : vertex;
+			}
+		}
+
+		//Bounding sphere around the box of the vertices & the cone of the triangle normals
+		static void ComputeMeshletBounds(Meshlet& meshlet, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+		{
+			const uint32_t endIndex{ meshlet.firstIndex + meshlet.triangleCount * 3 };
+
+			Bounds bounds{};
+			meshlet.vertexBegin = UINT32_MAX;
+			meshlet.vertexEnd = 0;
+			for (uint32_t index{ meshlet.firstIndex }; index < endIndex; ++index)
+			{
+				bounds.Grow(vertices[indices[index]].position);
+				meshlet.vertexBegin = std::min(meshlet.vertexBegin, indices[index]);
+				meshlet.vertexEnd = std::max(meshlet.vertexEnd, indices[index] + 1);
+			}
+
+			meshlet.center = (bounds.min + bounds.max) * 0.5f;
+			float squaredRadius{};
+			for (uint32_t index{ meshlet.firstIndex }; index < endIndex; ++index)
+			{
+				squaredRadius = std::max(squaredRadius, (vertices[indices[index]].position - meshlet.center).SqrMagnitude());
+			}
+			meshlet.radius = sqrtf(squaredRadius);
+
+			//Cross(p1 - p0, p2 - p0) points outwards, the same way as the OBJ normals
+			//Zero area triangles are never drawn, they keep a zero normal & don't widen the cone
+			std::vector<Vector3> normals(meshlet.triangleCount);
+			Vector3 normalSum{};
+			for (uint32_t triangle{ 0 }; triangle < meshlet.triangleCount; ++triangle)
+			{
+				const uint32_t index{ meshlet.firstIndex + triangle * 3 };
+				const Vector3& position0{ vertices[indices[index]].position };
+				const Vector3 normal{ Vector3::Cross(vertices[indices[index + 1]].position - position0, vertices[indices[index + 2]].position - position0) };
+
+				const float length{ normal.Magnitude() };
+				if (length > 0.f)
+				{
+					normals[triangle] = normal / length;
+					normalSum += normals[triangle];
+				}
+			}
+
+			//Unreachable cutoff, the meshlet is never rejected for facing away
+			meshlet.coneApex = meshlet.center;
+			meshlet.coneAxis = Vector3::UnitZ;
+			meshlet.coneCutoff = 2.f;
+
+			const float sumLength{ normalSum.Magnitude() };
+			if (sumLength <= FLT_EPSILON)
+				return;
+
+			const Vector3 axis{ normalSum / sumLength };
+			float minDot{ 1.f };
+			for (const Vector3& normal : normals)
+			{
+				if (normal.SqrMagnitude() > 0.f)
+				{
+					minDot = std::min(minDot, Vector3::Dot(axis, normal));
+				}
+			}
+
+			//Normals spread over (almost) a half sphere, some triangle always faces the viewer
+			if (minDot <= 0.1f)
+				return;
+
+			//Apex on the axis behind every triangle's plane, any viewpoint in the cone of half angle 90 - spread below it is behind all of them
+			//Dot(axis, normal) >= minDot, so the spread's cosine is minDot & the cutoff is the cosine of 90 - spread
+			float maxDistance{};
+			for (uint32_t triangle{ 0 }; triangle < meshlet.triangleCount; ++triangle)
+			{
+				const Vector3& normal{ normals[triangle] };
+				if (normal.SqrMagnitude() > 0.f)
+				{
+					const Vector3& position0{ vertices[indices[meshlet.firstIndex + triangle * 3]].position };
+					maxDistance = std::max(maxDistance, Vector3::Dot(meshlet.center - position0, normal) / Vector3::Dot(axis, normal));
+				}
+			}
+
+			meshlet.coneApex = meshlet.center - axis * maxDistance;
+			meshlet.coneAxis = axis;
+			meshlet.coneCutoff = sqrtf(1.f - minDot * minDot);
+		}
+
+		void BuildMeshlets(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<Meshlet>& meshlets)
+		{
+			meshlets.clear();
+
+			const size_t triangleCount{ indices.size() / 3 };
+			const size_t vertexCount{ vertices.size() };
+			if (triangleCount == 0)
+				return;
+
+			//Vertices split at UV & normal seams still share a position, neighbours are found through the first vertex at every position
+			std::vector<uint32_t> positionIds{};
+			WeldPositions(vertices, positionIds);
+
+			//Triangles touching every position, packed per position id like in OptimizeVertexCache: positionTriangles[positionOffsets[p] .. positionOffsets[p + 1]]
+			std::vector<uint32_t> positionOffsets(vertexCount + 1, 0);
+			for (size_t index{ 0 }; index < triangleCount * 3; ++index)
+			{
+				++positionOffsets[positionIds[indices[index]] + 1];
+			}
+			for (size_t vertex{ 0 }; vertex < vertexCount; ++vertex)
+			{
+				positionOffsets[vertex + 1] += positionOffsets[vertex];
+			}
+
+			std::vector<uint32_t> positionTriangles(triangleCount * 3);
+			std::vector<uint32_t> positionFill(positionOffsets.begin(), positionOffsets.end() - 1);
+			for (size_t triangle{ 0 }; triangle < triangleCount; ++triangle)
+			{
+				for (size_t corner{ 0 }; corner < 3; ++corner)
+				{
+					positionTriangles[positionFill[positionIds[indices[triangle * 3 + corner]]]++] = static_cast<uint32_t>(triangle);
+				}
+			}
+
+			//Zero area triangles keep a zero normal, they fit in any meshlet
+			std::vector<Vector3> triangleNormals(triangleCount);
+			for (size_t triangle{ 0 }; triangle < triangleCount; ++triangle)
+			{
+				const Vector3& position0{ vertices[indices[triangle * 3]].position };
+				const Vector3 normal{ Vector3::Cross(vertices[indices[triangle * 3 + 1]].position - position0, vertices[indices[triangle * 3 + 2]].position - position0) };
+
+				const float length{ normal.Magnitude() };
+				if (length > 0.f)
+				{
+					triangleNormals[triangle] = normal / length;
+				}
+			}
+
+			std::vector<uint32_t> meshletIndices{};
+			meshletIndices.reserve(triangleCount * 3);
+			std::vector<bool> isTriangleUsed(triangleCount, false);
+
+			//Meshlet a vertex was last added to, the current one is always meshlets.size()
+			std::vector<uint32_t> vertexMeshlets(vertexCount, UINT32_MAX);
+			std::vector<uint32_t> meshletVertices{};
+			meshletVertices.reserve(Meshlet::MAX_VERTICES);
+
+			//Seeds follow the index order, after OptimizeVertexCache the next free triangle is close to the last meshlet
+			size_t seed{ 0 };
+			while (true)
+			{
+				while (seed < triangleCount && isTriangleUsed[seed])
+				{
+					++seed;
+				}
+				if (seed == triangleCount)
+					break;
+
+				const uint32_t current{ static_cast<uint32_t>(meshlets.size()) };
+				Meshlet meshlet{};
+				meshlet.firstIndex = static_cast<uint32_t>(meshletIndices.size());
+				meshletVertices.clear();
+				Vector3 normalSum{};
+
+				uint32_t triangle{ static_cast<uint32_t>(seed) };
+				while (triangle != UINT32_MAX)
+				{
+					isTriangleUsed[triangle] = true;
+					for (size_t corner{ 0 }; corner < 3; ++corner)
+					{
+						const uint32_t vertex{ indices[triangle * 3 + corner] };
+						meshletIndices.push_back(vertex);
+						if (vertexMeshlets[vertex] != current)
+						{
+							vertexMeshlets[vertex] = current;
+							meshletVertices.push_back(vertex);
+						}
+					}
+					normalSum += triangleNormals[triangle];
+					++meshlet.triangleCount;
+
+					if (meshlet.triangleCount == Meshlet::MAX_TRIANGLES)
+						break;
+
+					//Grows through triangles sharing a vertex with the meshlet: every new vertex costs 1
+					//& facing away from the meshlet's average normal costs up to NORMAL_WEIGHT, so the meshlet stays flat enough for a useful cone
+					const float sumLength{ normalSum.Magnitude() };
+					const Vector3 axis{ sumLength > 0.f ? normalSum / sumLength : Vector3{} };
+
+					triangle = UINT32_MAX;
+					float bestScore{ FLT_MAX };
+					for (const uint32_t meshletVertex : meshletVertices)
+					{
+						const uint32_t positionId{ positionIds[meshletVertex] };
+						for (uint32_t offset{ positionOffsets[positionId] }; offset < positionOffsets[positionId + 1]; ++offset)
+						{
+							const uint32_t candidate{ positionTriangles[offset] };
+							if (isTriangleUsed[candidate])
+								continue;
+
+							const uint32_t vertex0{ indices[candidate * 3] };
+							const uint32_t vertex1{ indices[candidate * 3 + 1] };
+							const uint32_t vertex2{ indices[candidate * 3 + 2] };
+							const bool isNew0{ vertexMeshlets[vertex0] != current };
+							const bool isNew1{ vertexMeshlets[vertex1] != current && vertex1 != vertex0 };
+							const bool isNew2{ vertexMeshlets[vertex2] != current && vertex2 != vertex0 && vertex2 != vertex1 };
+							const uint32_t newVertexCount{ static_cast<uint32_t>(isNew0) + isNew1 + isNew2 };
+							if (meshletVertices.size() + newVertexCount > Meshlet::MAX_VERTICES)
+								continue;
+
+							const float score{ newVertexCount + (1.f - Vector3::Dot(axis, triangleNormals[candidate])) * NORMAL_WEIGHT };
+							if (score < bestScore)
+							{
+								bestScore = score;
+								triangle = candidate;
+							}
+						}
+					}
+				}
+
+				meshlets.push_back(meshlet);
+			}
+
+			//Every meshlet is a contiguous range of the new list, renumbering the vertices keeps a meshlet's vertices close together as well
+			indices = std::move(meshletIndices);
+			OptimizeVertexFetch(vertices, indices);
+
+			for (Meshlet& meshlet : meshlets)
+			{
+				ComputeMeshletBounds(meshlet, vertices, indices);
+			}
+		}
+
+		void BuildMeshlets(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const std::vector<MeshLod>& lods, std::vector<Meshlet>& meshlets, std::vector<uint32_t>& lodMeshletOffsets)
+		{
+			meshlets.clear();
+			lodMeshletOffsets.clear();
+
+			std::vector<Vertex> lodVertices{};
+			std::vector<uint32_t> lodIndices{};
+			std::vector<Meshlet> lodMeshlets{};
+			for (const MeshLod& lod : lods)
+			{
+				//Split with level local indices, only the order changes so everything fits back in the same ranges
+				lodVertices.assign(vertices.begin() + lod.firstVertex, vertices.begin() + lod.firstVertex + lod.vertexCount);
+				lodIndices.resize(lod.indexCount);
+				for (uint32_t index{ 0 }; index < lod.indexCount; ++index)
+				{
+					lodIndices[index] = indices[lod.firstIndex + index] - lod.firstVertex;
+				}
+
+				BuildMeshlets(lodVertices, lodIndices, lodMeshlets);
+
+				std::copy(lodVertices.begin(), lodVertices.end(), vertices.begin() + lod.firstVertex);
+				for (uint32_t index{ 0 }; index < lod.indexCount; ++index)
+				{
+					indices[lod.firstIndex + index] = lodIndices[index] + lod.firstVertex;
+				}
+
+				lodMeshletOffsets.push_back(static_cast<uint32_t>(meshlets.size()));
+				for (Meshlet& meshlet : lodMeshlets)
+				{
+					meshlet.firstIndex += lod.firstIndex;
+					meshlet.vertexBegin += lod.firstVertex;
+					meshlet.vertexEnd += lod.firstVertex;
+					meshlets.push_back(meshlet);
+				}
+			}
+			lodMeshletOffsets.push_back(static_cast<uint32_t>(meshlets.size()));
+		}
+
+		void Optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+		{
+			const float acmrBefore{ CalculateACMR(indices, vertices.size()) };
+
+			OptimizeVertexCache(indices, vertices.size());
+			OptimizeVertexFetch(vertices, indices);
+
+			const float acmrAfter{ CalculateACMR(indices, vertices.size()) };
+			std::cout << "Vertex cache ACMR (" << CACHE_SIZE << " entries): " << acmrBefore << " -> " << acmrAfter << '\n';
+		}
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "DataTypes.h"
+
+namespace dae
+{
+	//Reorders an indexed triangle list for the post-transform vertex cache and for linear vertex fetches
+	//Only the order changes, the triangles themselves & their winding stay the same
+	namespace MeshOptimizer
+	{
+		constexpr uint32_t CACHE_SIZE{ 32 };
+
+		//Average cache misses per triangle for a FIFO cache of cacheSize vertices, 0.5 is the best a regular grid can do, 3 the worst
+		float CalculateACMR(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = CACHE_SIZE);
+
+		//Tom Forsyth's linear-speed vertex cache optimisation: greedily emits the triangle whose vertices score best in a simulated LRU cache
+		void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+		//Renumbers vertices in the order the indices first use them, unreferenced vertices move to the back
+		void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+		//Gives every vertex the index of a vertex with exactly the same position, the same one for all of them
+		//Vertices split at UV & normal seams end up with the same id, so topology can be followed across the seams
+		void WeldPositions(const std::vector<Vertex>& vertices, std::vector<uint32_t>& positionIds);
+
+		//Both passes, prints the ACMR before & after
+		void Optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+		//Splits a triangle list into meshlets within Meshlet's limits, each grown from a seed through neighbouring triangles that add few vertices & face the same way
+		//Reorders the triangles so every meshlet is a contiguous index range & renumbers the vertices like OptimizeVertexFetch
+		//Works best after OptimizeVertexCache, which keeps the seeds of consecutive meshlets close together
+		void BuildMeshlets(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<Meshlet>& meshlets);
+
+		//Same for every level of detail on its own, each level keeps its vertex & index range
+		//The meshlets of level lod are meshlets[lodMeshletOffsets[lod] .. lodMeshletOffsets[lod + 1]]
+		void BuildMeshlets(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const std::vector<MeshLod>& lods, std::vector<Meshlet>& meshlets, std::vector<uint32_t>& lodMeshletOffsets);
+	}
+}
@@ -0,0 +1,647 @@
+#include "pch.h"
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+namespace dae
+{
+	namespace MeshSimplifier
+	{
+		//Border & seam edges add a plane standing on them, weighted this much more than a triangle of the same size so outlines hardly move
+		constexpr float EDGE_WEIGHT{ 10.f };
+
+		//A collapse is skipped when it turns one of the remaining triangles further than this cosine, folded triangles look far worse than their error says
+		constexpr float MIN_NORMAL_COSINE{ 0.25f };
+
+		//Largest distance a collapse may move the surface, as a share of the mesh's bounding box diagonal
+		//A level stops above its triangle target rather than tearing apart thin & loose parts
+		constexpr float MAX_ERROR{ 0.01f };
+
+		//Open edge of a vertex when it has none or more than one
+		constexpr uint32_t NO_EDGE{ UINT32_MAX };
+		constexpr uint32_t MANY_EDGES{ UINT32_MAX - 1 };
+
+		enum class VertexKind
+		{
+			Manifold,	//Inside a surface, collapses into any neighbour
+			Border,		//On an open border, only collapses along it into another border vertex
+			Seam,		//On a UV or normal seam with one twin on the other side, both collapse along the seam together
+			Locked		//Corners, seam ends & anything else that changes shape or attributes when moved
+		};
+
+		//Sum of squared distances to a set of planes as a symmetric 4x4 matrix: error(p) = p A p + 2 b p + c
+		struct Quadric
+		{
+			double a00{}, a11{}, a22{}, a01{}, a02{}, a12{};
+			double b0{}, b1{}, b2{};
+			double c{};
+			double weight{};
+
+			//Plane through Dot(normal, p) + distance = 0, normal of unit length
+			static Quadric FromPlane(const Vector3& normal, float distance, float weight)
+			{
+				const double w{ weight };
+
+				Quadric quadric{};
+				quadric.a00 = w * normal.x * normal.x;
+				quadric.a11 = w * normal.y * normal.y;
+				quadric.a22 = w * normal.z * normal.z;
+				quadric.a01 = w * normal.x * normal.y;
+				quadric.a02 = w * normal.x * normal.z;
+				quadric.a12 = w * normal.y * normal.z;
+				quadric.b0 = w * normal.x * distance;
+				quadric.b1 = w * normal.y * distance;
+				quadric.b2 = w * normal.z * distance;
+				quadric.c = w * distance * distance;
+				quadric.weight = w;
+				return quadric;
+			}
+
+			Quadric& operator+=(const Quadric& other)
+			{
+				a00 += other.a00;
+				a11 += other.a11;
+				a22 += other.a22;
+				a01 += other.a01;
+				a02 += other.a02;
+				a12 += other.a12;
+				b0 += other.b0;
+				b1 += other.b1;
+				b2 += other.b2;
+				c += other.c;
+				weight += other.weight;
+				return *this;
+			}
+
+			//Weighted mean of the squared distances, so small parts and big ones are held to the same distance
+			float GetError(const Vector3& point) const
+			{
+				if (weight <= 0.0)
+					return 0.f;
+
+				const double x{ point.x }, y{ point.y }, z{ point.z };
+				const double error
+				{
+					a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+					2.0 * (b0 * x + b1 * y + b2 * z) + c
+				};
+
+				//Rounding can take a zero error slightly below zero
+				return static_cast<float>(std::abs(error) / weight);
+			}
+		};
+
+		struct Collapse
+		{
+			uint32_t from{};
+			uint32_t to{};
+			float error{};
+		};
+
+		//Everything the passes look up, the vertex kinds & open edges are set up once and follow the collapses after that
+		struct SimplifyState
+		{
+			const std::vector<Vertex>& vertices;
+			std::vector<uint32_t> positionIds{};
+
+			//Next vertex with the same position, a ring through all of them
+			std::vector<uint32_t> wedges{};
+
+			std::vector<VertexKind> kinds{};
+
+			//Edges of a vertex that only one triangle uses, in the direction of that triangle's winding
+			std::vector<uint32_t> openOut{};
+			std::vector<uint32_t> openIn{};
+
+			//Per position id, every vertex at a position uses the same one
+			std::vector<Quadric> quadrics{};
+
+			//Triangles using every vertex in the current indices: vertexTriangles[triangleOffsets[v] .. triangleOffsets[v + 1]]
+			std::vector<uint32_t> triangleOffsets{};
+			std::vector<uint32_t> vertexTriangles{};
+		};
+
+		static void BuildVertexTriangles(SimplifyState& state, const std::vector<uint32_t>& indices)
+		{
+			const size_t vertexCount{ state.vertices.size() };
+			state.triangleOffsets.assign(vertexCount + 1, 0);
+			for (const uint32_t index : indices)
+			{
+				++state.triangleOffsets[index + 1];
+			}
+			for (size_t vertex{ 0 }; vertex < vertexCount; ++vertex)
+			{
+				state.triangleOffsets[vertex + 1] += state.triangleOffsets[vertex];
+			}
+
+			state.vertexTriangles.resize(indices.size());
+			std::vector<uint32_t> fill(state.triangleOffsets.begin(), state.triangleOffsets.end() - 1);
+			for (size_t index{ 0 }; index < indices.size(); ++index)
+			{
+				state.vertexTriangles[fill[indices[index]]++] = static_cast<uint32_t>(index / 3);
+			}
+		}
+
+		//Corner of the triangle that follows the vertex in winding order
+		static uint32_t GetNextCorner(const std::vector<uint32_t>& indices, uint32_t triangle, uint32_t vertex)
+		{
+			const uint32_t* pCorners{ &indices[triangle * 3] };
+			return pCorners[0] == vertex ? pCorners[1] : pCorners[1] == vertex ? pCorners[2] : pCorners[0];
+		}
+
+		static bool HasEdge(const SimplifyState& state, const std::vector<uint32_t>& indices, uint32_t from, uint32_t to)
+		{
+			for (uint32_t offset{ state.triangleOffsets[from] }; offset < state.triangleOffsets[from + 1]; ++offset)
+			{
+				if (GetNextCorner(indices, state.vertexTriangles[offset], from) == to)
+					return true;
+			}
+			return false;
+		}
+
+		//Same as HasEdge, but between any vertices at the two positions
+		static bool HasPositionEdge(const SimplifyState& state, const std::vector<uint32_t>& indices, uint32_t from, uint32_t to)
+		{
+			uint32_t wedge{ from };
+			do
+			{
+				for (uint32_t offset{ state.triangleOffsets[wedge] }; offset < state.triangleOffsets[wedge + 1]; ++offset)
+				{
+					if (state.positionIds[GetNextCorner(indices, state.vertexTriangles[offset], wedge)] == state.positionIds[to])
+						return true;
+				}
+				wedge = state.wedges[wedge];
+			} while (wedge != from);
+
+			return false;
+		}
+
+		static bool IsSingleEdge(uint32_t edge)
+		{
+			return edge < MANY_EDGES;
+		}
+
+		//An edge only one triangle uses is open, it's either on the border of the surface or on a seam when a triangle at the same positions runs the other way
+		static void ClassifyVertices(SimplifyState& state, const std::vector<uint32_t>& indices)
+		{
+			const size_t vertexCount{ state.vertices.size() };
+			state.openOut.assign(vertexCount, NO_EDGE);
+			state.openIn.assign(vertexCount, NO_EDGE);
+
+			for (uint32_t index{ 0 }; index < indices.size(); ++index)
+			{
+				const uint32_t from{ indices[index] };
+				const uint32_t to{ indices[index % 3 == 2 ? index - 2 : index + 1] };
+				if (HasEdge(state, indices, to, from))
+					continue;
+
+				state.openOut[from] = state.openOut[from] == NO_EDGE ? to : MANY_EDGES;
+				state.openIn[to] = state.openIn[to] == NO_EDGE ? from : MANY_EDGES;
+			}
+
+			state.kinds.assign(vertexCount, VertexKind::Locked);
+			for (uint32_t vertex{ 0 }; vertex < vertexCount; ++vertex)
+			{
+				const uint32_t twin{ state.wedges[vertex] };
+				const bool isSingleWedge{ twin == vertex };
+				const bool isDoubleWedge{ !isSingleWedge && state.wedges[twin] == vertex };
+
+				const uint32_t out{ state.openOut[vertex] };
+				const uint32_t in{ state.openIn[vertex] };
+
+				if (isSingleWedge && out == NO_EDGE && in == NO_EDGE)
+				{
+					state.kinds[vertex] = VertexKind::Manifold;
+				}
+				else if (isSingleWedge && IsSingleEdge(out) && IsSingleEdge(in))
+				{
+					//Open in position space as well, otherwise a seam ends here
+					if (!HasPositionEdge(state, indices, out, vertex) && !HasPositionEdge(state, indices, vertex, in))
+					{
+						state.kinds[vertex] = VertexKind::Border;
+					}
+				}
+				else if (isDoubleWedge && IsSingleEdge(out) && IsSingleEdge(in) && IsSingleEdge(state.openOut[twin]) && IsSingleEdge(state.openIn[twin]))
+				{
+					//The twin's open edges run along the same positions in the other direction
+					if (state.positionIds[out] == state.positionIds[state.openIn[twin]] && state.positionIds[in] == state.positionIds[state.openOut[twin]])
+					{
+						state.kinds[vertex] = VertexKind::Seam;
+					}
+				}
+			}
+		}
+
+		static void ComputeQuadrics(SimplifyState& state, const std::vector<uint32_t>& indices)
+		{
+			state.quadrics.assign(state.vertices.size(), Quadric{});
+
+			for (size_t triangle{ 0 }; triangle < indices.size() / 3; ++triangle)
+			{
+				const uint32_t* pCorners{ &indices[triangle * 3] };
+				const Vector3& position0{ state.vertices[pCorners[0]].position };
+				Vector3 normal{ Vector3::Cross(state.vertices[pCorners[1]].position - position0, state.vertices[pCorners[2]].position - position0) };
+
+				const float doubleArea{ normal.Magnitude() };
+				if (doubleArea <= 0.f)
+					continue;
+
+				normal /= doubleArea;
+				const Quadric plane{ Quadric::FromPlane(normal, -Vector3::Dot(normal, position0), doubleArea * 0.5f) };
+
+				for (uint32_t corner{ 0 }; corner < 3; ++corner)
+				{
+					state.quadrics[state.positionIds[pCorners[corner]]] += plane;
+
+					const uint32_t from{ pCorners[corner] };
+					const uint32_t to{ pCorners[(corner + 1) % 3] };
+					if (HasEdge(state, indices, to, from))
+						continue;
+
+					const Vector3 edge{ state.vertices[to].position - state.vertices[from].position };
+					const float squaredLength{ edge.SqrMagnitude() };
+					if (squaredLength <= 0.f)
+						continue;
+
+					const Vector3 edgeNormal{ Vector3::Cross(edge, normal).Normalized() };
+					const Quadric edgePlane{ Quadric::FromPlane(edgeNormal, -Vector3::Dot(edgeNormal, state.vertices[from].position), squaredLength * EDGE_WEIGHT) };
+					state.quadrics[state.positionIds[from]] += edgePlane;
+					state.quadrics[state.positionIds[to]] += edgePlane;
+				}
+			}
+		}
+
+		//Vertex on the other side of the seam that has to collapse along with from, NO_EDGE when there's none
+		static uint32_t GetTwinTarget(const SimplifyState& state, uint32_t from, uint32_t to)
+		{
+			const uint32_t twin{ state.wedges[from] };
+			const uint32_t twinTo{ state.openOut[from] == to ? state.openIn[twin] : state.openOut[twin] };
+			if (!IsSingleEdge(twinTo) || twinTo == to || state.positionIds[twinTo] != state.positionIds[to])
+				return NO_EDGE;
+
+			return twinTo;
+		}
+
+		static bool CanCollapse(const SimplifyState& state, uint32_t from, uint32_t to)
+		{
+			if (state.positionIds[from] == state.positionIds[to])
+				return false;
+
+			const bool isAlongOpenEdge{ state.openOut[from] == to || state.openIn[from] == to };
+			switch (state.kinds[from])
+			{
+			case VertexKind::Manifold:
+				return true;
+			case VertexKind::Border:
+				return (state.kinds[to] == VertexKind::Border || state.kinds[to] == VertexKind::Locked) && isAlongOpenEdge;
+			case VertexKind::Seam:
+				return (state.kinds[to] == VertexKind::Seam || state.kinds[to] == VertexKind::Locked) && isAlongOpenEdge && GetTwinTarget(state, from, to) != NO_EDGE;
+			default:
+				return false;
+			}
+		}
+
+		//Any triangle around from that stays after the collapse, but turns too far or flips when from moves onto to
+		static bool HasFlippedTriangle(const SimplifyState& state, const std::vector<uint32_t>& indices, uint32_t from, uint32_t to)
+		{
+			const Vector3& fromPosition{ state.vertices[from].position };
+			const Vector3& toPosition{ state.vertices[to].position };
+
+			for (uint32_t offset{ state.triangleOffsets[from] }; offset < state.triangleOffsets[from + 1]; ++offset)
+			{
+				const uint32_t triangle{ state.vertexTriangles[offset] };
+				const uint32_t next{ GetNextCorner(indices, triangle, from) };
+				const uint32_t previous{ GetNextCorner(indices, triangle, next) };
+				if (state.positionIds[next] == state.positionIds[to] || state.positionIds[previous] == state.positionIds[to])
+					continue;
+
+				const Vector3& nextPosition{ state.vertices[next].position };
+				const Vector3& previousPosition{ state.vertices[previous].position };
+				const Vector3 oldNormal{ Vector3::Cross(nextPosition - fromPosition, previousPosition - fromPosition) };
+				const Vector3 newNormal{ Vector3::Cross(nextPosition - toPosition, previousPosition - toPosition) };
+
+				if (Vector3::Dot(oldNormal, newNormal) < MIN_NORMAL_COSINE * oldNormal.Magnitude() * newNormal.Magnitude())
+					return true;
+			}
+			return false;
+		}
+
+		static size_t CountCollapsedTriangles(const SimplifyState& state, const std::vector<uint32_t>& indices, uint32_t from, uint32_t to)
+		{
+			size_t count{};
+			for (uint32_t offset{ state.triangleOffsets[from] }; offset < state.triangleOffsets[from + 1]; ++offset)
+			{
+				const uint32_t* pCorners{ &indices[state.vertexTriangles[offset] * 3] };
+				for (uint32_t corner{ 0 }; corner < 3; ++corner)
+				{
+					if (state.positionIds[pCorners[corner]] == state.positionIds[to])
+					{
+						++count;
+						break;
+					}
+				}
+			}
+			return count;
+		}
+
+		//An open edge to a collapsed vertex now ends at the vertex it collapsed into, unless that's this vertex, then it takes over the collapsed one's edge
+		static void RemapOpenEdges(std::vector<uint32_t>& openEdges, const std::vector<uint32_t>& remap)
+		{
+			for (uint32_t vertex{ 0 }; vertex < openEdges.size(); ++vertex)
+			{
+				const uint32_t edge{ openEdges[vertex] };
+				if (!IsSingleEdge(edge))
+					continue;
+
+				if (remap[edge] == vertex)
+				{
+					const uint32_t collapsedEdge{ openEdges[edge] };
+					openEdges[vertex] = IsSingleEdge(collapsedEdge) ? remap[collapsedEdge] : collapsedEdge;
+				}
+				else
+				{
+					openEdges[vertex] = remap[edge];
+				}
+			}
+		}
+
+		//Like MeshOptimizer::WeldPositions, but vertices also need the same UV to get the same id
+		static void WeldUVs(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& positionIds, std::vector<uint32_t>& uvIds)
+		{
+			const size_t vertexCount{ vertices.size() };
+
+			std::vector<uint32_t> sortedVertices(vertexCount);
+			for (uint32_t vertex{ 0 }; vertex < vertexCount; ++vertex)
+			{
+				sortedVertices[vertex] = vertex;
+			}
+			std::sort(sortedVertices.begin(), sortedVertices.end(), [&](uint32_t left, uint32_t right)
+				{
+					if (positionIds[left] != positionIds[right])
+						return positionIds[left] < positionIds[right];
+					if (vertices[left].uv.x != vertices[right].uv.x)
+						return vertices[left].uv.x < vertices[right].uv.x;
+					return vertices[left].uv.y < vertices[right].uv.y;
+				});
+
+			uvIds.resize(vertexCount);
+			for (size_t index{ 0 }; index < vertexCount; ++index)
+			{
+				const uint32_t vertex{ sortedVertices[index] };
+				bool isSame{ false };
+				if (index > 0)
+				{
+					const uint32_t previous{ sortedVertices[index - 1] };
+					isSame = positionIds[previous] == positionIds[vertex] && vertices[previous].uv.x == vertices[vertex].uv.x && vertices[previous].uv.y == vertices[vertex].uv.y;
+				}
+				uvIds[vertex] = isSame ? uvIds[sortedVertices[index - 1]] : vertex;
+			}
+		}
+
+		void Simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetTriangleCount, std::vector<uint32_t>& simplifiedIndices)
+		{
+			const size_t vertexCount{ vertices.size() };
+
+			SimplifyState state{ vertices };
+			MeshOptimizer::WeldPositions(vertices, state.positionIds);
+
+			//Vertices that only differ in their normal & tangent are simplified as one, only UV seams are kept as seams
+			//Hard edges come back at the end, when every corner picks the normal closest to its triangle's
+			std::vector<uint32_t> uvIds{};
+			WeldUVs(vertices, state.positionIds, uvIds);
+
+			//Rings through the vertices that stand for each position & UV
+			constexpr uint32_t NO_VERTEX{ UINT32_MAX };
+			std::vector<uint32_t> firstWedges(vertexCount, NO_VERTEX);
+			state.wedges.resize(vertexCount);
+			for (uint32_t vertex{ 0 }; vertex < vertexCount; ++vertex)
+			{
+				state.wedges[vertex] = vertex;
+				if (uvIds[vertex] != vertex)
+					continue;
+
+				uint32_t& first{ firstWedges[state.positionIds[vertex]] };
+				if (first == NO_VERTEX)
+				{
+					first = vertex;
+				}
+				else
+				{
+					state.wedges[vertex] = state.wedges[first];
+					state.wedges[first] = vertex;
+				}
+			}
+
+			//Triangles with two corners at the same position have no area, they'd only get in the way of the edge lookups
+			simplifiedIndices.clear();
+			simplifiedIndices.reserve(indices.size());
+			for (size_t index{ 0 }; index + 2 < indices.size(); index += 3)
+			{
+				const uint32_t vertex0{ uvIds[indices[index]] };
+				const uint32_t vertex1{ uvIds[indices[index + 1]] };
+				const uint32_t vertex2{ uvIds[indices[index + 2]] };
+
+				const uint32_t position0{ state.positionIds[vertex0] };
+				const uint32_t position1{ state.positionIds[vertex1] };
+				const uint32_t position2{ state.positionIds[vertex2] };
+				if (position0 != position1 && position1 != position2 && position2 != position0)
+				{
+					simplifiedIndices.push_back(vertex0);
+					simplifiedIndices.push_back(vertex1);
+					simplifiedIndices.push_back(vertex2);
+				}
+			}
+
+			BuildVertexTriangles(state, simplifiedIndices);
+			ClassifyVertices(state, simplifiedIndices);
+			ComputeQuadrics(state, simplifiedIndices);
+
+			Bounds bounds{};
+			for (const Vertex& vertex : vertices)
+			{
+				bounds.Grow(vertex.position);
+			}
+			const float maxDistance{ (bounds.max - bounds.min).Magnitude() * MAX_ERROR };
+			const float maxSquaredError{ maxDistance * maxDistance };
+
+			std::vector<Collapse> collapses{};
+			std::vector<uint32_t> remap(vertexCount);
+			std::vector<bool> isPositionTouched(vertexCount);
+
+			//Every pass collapses the cheapest edges that don't touch each other, the rest wait for the next pass with updated quadrics
+			while (simplifiedIndices.size() / 3 > targetTriangleCount)
+			{
+				const size_t triangleCount{ simplifiedIndices.size() / 3 };
+				BuildVertexTriangles(state, simplifiedIndices);
+
+				collapses.clear();
+				for (uint32_t index{ 0 }; index < simplifiedIndices.size(); ++index)
+				{
+					const uint32_t vertex0{ simplifiedIndices[index] };
+					const uint32_t vertex1{ simplifiedIndices[index % 3 == 2 ? index - 2 : index + 1] };
+
+					if (CanCollapse(state, vertex0, vertex1))
+					{
+						const float error{ state.quadrics[state.positionIds[vertex0]].GetError(vertices[vertex1].position) };
+						if (error <= maxSquaredError)
+							collapses.push_back({ vertex0, vertex1, error });
+					}
+					if (CanCollapse(state, vertex1, vertex0))
+					{
+						const float error{ state.quadrics[state.positionIds[vertex1]].GetError(vertices[vertex0].position) };
+						if (error <= maxSquaredError)
+							collapses.push_back({ vertex1, vertex0, error });
+					}
+				}
+
+				std::sort(collapses.begin(), collapses.end(), [](const Collapse& left, const Collapse& right)
+					{
+						return left.error < right.error;
+					});
+
+				for (uint32_t vertex{ 0 }; vertex < vertexCount; ++vertex)
+				{
+					remap[vertex] = vertex;
+				}
+				std::fill(isPositionTouched.begin(), isPositionTouched.end(), false);
+
+				const size_t removeGoal{ triangleCount - targetTriangleCount };
+				size_t removedCount{};
+				size_t collapseCount{};
+				for (const Collapse& collapse : collapses)
+				{
+					if (removedCount >= removeGoal)
+						break;
+
+					const uint32_t fromPosition{ state.positionIds[collapse.from] };
+					const uint32_t toPosition{ state.positionIds[collapse.to] };
+					if (isPositionTouched[fromPosition] || isPositionTouched[toPosition])
+						continue;
+
+					const bool isSeam{ state.kinds[collapse.from] == VertexKind::Seam };
+					const uint32_t twinFrom{ state.wedges[collapse.from] };
+					const uint32_t twinTo{ isSeam ? GetTwinTarget(state, collapse.from, collapse.to) : NO_EDGE };
+
+					if (HasFlippedTriangle(state, simplifiedIndices, collapse.from, collapse.to) || (isSeam && HasFlippedTriangle(state, simplifiedIndices, twinFrom, twinTo)))
+						continue;
+
+					removedCount += CountCollapsedTriangles(state, simplifiedIndices, collapse.from, collapse.to);
+					remap[collapse.from] = collapse.to;
+					if (isSeam)
+					{
+						removedCount += CountCollapsedTriangles(state, simplifiedIndices, twinFrom, twinTo);
+						remap[twinFrom] = twinTo;
+					}
+
+					state.quadrics[toPosition] += state.quadrics[fromPosition];
+					isPositionTouched[fromPosition] = true;
+					isPositionTouched[toPosition] = true;
+					++collapseCount;
+				}
+
+				if (collapseCount == 0)
+					break;
+
+				size_t writeIndex{};
+				for (size_t index{ 0 }; index < simplifiedIndices.size(); index += 3)
+				{
+					const uint32_t vertex0{ remap[simplifiedIndices[index]] };
+					const uint32_t vertex1{ remap[simplifiedIndices[index + 1]] };
+					const uint32_t vertex2{ remap[simplifiedIndices[index + 2]] };
+
+					const uint32_t position0{ state.positionIds[vertex0] };
+					const uint32_t position1{ state.positionIds[vertex1] };
+					const uint32_t position2{ state.positionIds[vertex2] };
+					if (position0 == position1 || position1 == position2 || position2 == position0)
+						continue;
+
+					simplifiedIndices[writeIndex++] = vertex0;
+					simplifiedIndices[writeIndex++] = vertex1;
+					simplifiedIndices[writeIndex++] = vertex2;
+				}
+				simplifiedIndices.resize(writeIndex);
+
+				RemapOpenEdges(state.openOut, remap);
+				RemapOpenEdges(state.openIn, remap);
+			}
+
+			//Vertices with the position & UV of every simplified vertex: uvVertices[uvOffsets[v] .. uvOffsets[v + 1]]
+			std::vector<uint32_t> uvOffsets(vertexCount + 1, 0);
+			for (uint32_t vertex{ 0 }; vertex < vertexCount; ++vertex)
+			{
+				++uvOffsets[uvIds[vertex] + 1];
+			}
+			for (size_t vertex{ 0 }; vertex < vertexCount; ++vertex)
+			{
+				uvOffsets[vertex + 1] += uvOffsets[vertex];
+			}
+
+			std::vector<uint32_t> uvVertices(vertexCount);
+			std::vector<uint32_t> uvFill(uvOffsets.begin(), uvOffsets.end() - 1);
+			for (uint32_t vertex{ 0 }; vertex < vertexCount; ++vertex)
+			{
+				uvVertices[uvFill[uvIds[vertex]]++] = vertex;
+			}
+
+			//On a hard edge every side's triangles face closest to that side's normal, so they get their own vertices back
+			for (size_t index{ 0 }; index < simplifiedIndices.size(); index += 3)
+			{
+				const Vector3& position0{ vertices[simplifiedIndices[index]].position };
+				const Vector3 faceNormal{ Vector3::Cross(vertices[simplifiedIndices[index + 1]].position - position0, vertices[simplifiedIndices[index + 2]].position - position0) };
+
+				for (size_t corner{ index }; corner < index + 3; ++corner)
+				{
+					const uint32_t uvVertex{ simplifiedIndices[corner] };
+
+					float bestDot{ -FLT_MAX };
+					for (uint32_t offset{ uvOffsets[uvVertex] }; offset < uvOffsets[uvVertex + 1]; ++offset)
+					{
+						const uint32_t vertex{ uvVertices[offset] };
+						const float dot{ Vector3::Dot(vertices[vertex].normal, faceNormal) };
+						if (dot > bestDot)
+						{
+							bestDot = dot;
+							simplifiedIndices[corner] = vertex;
+						}
+					}
+				}
+			}
+		}
+
+		void BuildLodChain(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<MeshLod>& lods)
+		{
+			lods.clear();
+			lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0, static_cast<uint32_t>(vertices.size()) });
+
+			//Levels are appended behind the full mesh, which stays where it is
+			const std::vector<Vertex> fullVertices{ vertices };
+			const std::vector<uint32_t> fullIndices{ indices };
+			const size_t fullTriangleCount{ fullIndices.size() / 3 };
+
+			std::vector<uint32_t> lodIndices{};
+			for (uint32_t lod{ 1 }; lod < MeshLod::MAX_COUNT; ++lod)
+			{
+				const size_t targetTriangleCount{ static_cast<size_t>(fullTriangleCount * MeshLod::TRIANGLE_RATIOS[lod]) };
+				Simplify(fullVertices, fullIndices, targetTriangleCount, lodIndices);
+
+				if (lodIndices.empty() || lodIndices.size() >= lods.back().indexCount)
+					break;
+
+				//Only the vertices the level uses are kept, renumbering puts them at the front
+				std::vector<Vertex> lodVertices{ fullVertices };
+				MeshOptimizer::OptimizeVertexCache(lodIndices, lodVertices.size());
+				MeshOptimizer::OptimizeVertexFetch(lodVertices, lodIndices);
+				lodVertices.resize(*std::max_element(lodIndices.begin(), lodIndices.end()) + 1);
+
+				const MeshLod level{ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(lodIndices.size()), static_cast<uint32_t>(vertices.size()), static_cast<uint32_t>(lodVertices.size()) };
+				for (const uint32_t index : lodIndices)
+				{
+					indices.push_back(level.firstVertex + index);
+				}
+				vertices.insert(vertices.end(), lodVertices.begin(), lodVertices.end());
+				lods.push_back(level);
+
+				std::cout << "LOD " << lod << ": " << level.indexCount / 3 << " triangles (" << 100.f * level.indexCount / fullIndices.size() << "%), " << level.vertexCount << " vertices\n";
+			}
+		}
+	}
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "DataTypes.h"
+
+namespace dae
+{
+	//Lowers the triangle count of an indexed triangle list with quadric error metrics (Garland & Heckbert)
+	//Edges are collapsed into one of their existing vertices, so the simplified indices still point into the original vertices
+	namespace MeshSimplifier
+	{
+		//Collapses the cheapest edges until at most targetTriangleCount triangles are left, or until every collapse left would move the surface too far
+		//Open borders & UV seams keep their shape: their vertices only slide along them, seam vertices together with their twin on the other side
+		//Vertices that only differ in their normal are simplified as one, every corner of the result gets the one that faces closest to its triangle
+		void Simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetTriangleCount, std::vector<uint32_t>& simplifiedIndices);
+
+		//Appends the levels of MeshLod::TRIANGLE_RATIOS behind the full mesh in vertices & indices and fills lods with all of them, level 0 included
+		//Every level is simplified from the full mesh & optimized for the vertex cache and fetches on its own
+		//A level can end above its ratio when the error gets too big, the chain ends early when it can't get below the triangle count of the one before it
+		void BuildLodChain(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<MeshLod>& lods);
+	}
+}
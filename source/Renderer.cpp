@@ -14,6 +14,9 @@ namespace dae
 		//Initialize
 		SDL_GetWindowSize(pWindow, &m_Width, &m_Height);
 
+		m_pAssetLoader = new AssetLoader{};
+
+#if !defined(SOFTWARE_ONLY)
 		//DirectX-------------------------
 
 		//Initialize DirectX pipeline
@@ -27,39 +30,119 @@ namespace dae
 		{
 			std::cout << "DirectX initialization failed!\n";
 		}
+#endif
 
 		//Software------------------------
-
-		//Create Buffers
-		m_pFrontBuffer = SDL_GetWindowSurface(m_pWindow);
-		m_pBackBuffer = SDL_CreateRGBSurface(0, m_Width, m_Height, 32, 0, 0, 0, 0);
-		m_pBackBufferPixels = (uint32_t*)m_pBackBuffer->pixels;
-
-		m_pDepthBufferPixels = new float[m_Width * m_Height];
-		ResetDepthBuffer();
+		InitializeSoftwareBuffers();
 		
 		//--------------------------------
 
 		m_Camera.Initialize(45.f, Vector3{ 0.f, 0.f, -50.f }, static_cast<float>(m_Width) / static_cast<float>(m_Height));
 
+#if !defined(SOFTWARE_ONLY)
 		InitializeDirectXMeshes();
+#endif
 		InitializeSoftwareMeshes();
 
 		PrintInfo();
 	}
 
+	Renderer::Renderer(int width, int height)
+		: m_Width{ width }
+		, m_Height{ height }
+	{
+		//Headless - no window, no DirectX
+		m_RenderStyle = RenderingStyle::Software;
+
+		m_pAssetLoader = new AssetLoader{};
+
+		InitializeSoftwareBuffers();
+
+		m_Camera.Initialize(45.f, Vector3{ 0.f, 0.f, -50.f }, static_cast<float>(m_Width) / static_cast<float>(m_Height));
+		m_Camera.CalculateMatrices();
+
+		InitializeSoftwareMeshes();
+	}
+
 	Renderer::~Renderer()
 	{
+		//Waits for the jobs that are loading & drops what wasn't published yet
+		delete m_pAssetLoader;
+		m_pAssetLoader = nullptr;
+
+#if !defined(SOFTWARE_ONLY)
 		DeleteDirectXResources();
+#endif
 		DeleteSoftwareResources();
 	}
 
 	void Renderer::Update(const Timer* pTimer)
 	{
+		m_pAssetLoader->PublishReady();
+
 		m_Camera.Update(pTimer);
 
+#if !defined(SOFTWARE_ONLY)
 		UpdateDirectX(pTimer);
-		UpdateSoftware(pTimer);
+#endif
+		UpdateSoftware(pTimer->GetElapsed());
+	}
+
+	void Renderer::UpdateHeadless(float elapsedSec)
+	{
+		m_pAssetLoader->PublishReady();
+
+		UpdateSoftware(elapsedSec);
+	}
+	void Renderer::WaitForAssets()
+	{
+		m_pAssetLoader->PublishAll();
+	}
+	void Renderer::SetCameraTransform(const Vector3& origin, float pitch, float yaw)
+	{
+		m_Camera.SetTransform(origin, pitch, yaw);
+	}
+	void Renderer::SetFilteringMethod(FilteringMethod filteringMethod)
+	{
+		m_FilteringMethod = filteringMethod;
+	}
+	void Renderer::SetShadingPipeline(ShadingPipeline shadingPipeline)
+	{
+		m_ShadingPipeline = shadingPipeline;
+		AllocatePipelineBuffers();
+	}
+	void Renderer::SetSpecularPrecision(SpecularPrecision specularPrecision)
+	{
+		m_SpecularPrecision = specularPrecision;
+	}
+	void Renderer::AddLight(const Light& light)
+	{
+		m_Lights.push_back(light);
+	}
+	void Renderer::ClearLights()
+	{
+		m_Lights.clear();
+	}
+	void Renderer::AddInstance(const Matrix& worldMatrix, uint32_t meshIndex)
+	{
+		//The draw index has to fit in the bin entry next to the index offset
+		if (meshIndex >= m_Meshes.size() || m_Instances.size() >= (CLIPPED_TRIANGLE_BIT >> m_InstanceShift))
+		{
+			std::cout << "Can't add instance of mesh " << meshIndex << '\n';
+			return;
+		}
+
+		m_Instances.push_back({ meshIndex, worldMatrix });
+		m_IsInstanceBvhDirty = true;
+	}
+	void Renderer::ClearInstances()
+	{
+		m_Instances.clear();
+		m_IsInstanceBvhDirty = true;
+	}
+	bool Renderer::SaveBackBuffer(const std::string& path) const
+	{
+		return SDL_SaveBMP(m_pBackBuffer, path.c_str()) == 0;
 	}
 
 	void Renderer::Render()
@@ -70,7 +153,9 @@ namespace dae
 			RenderSoftware();
 			break;
 		case dae::Renderer::RenderingStyle::DirectX:
+#if !defined(SOFTWARE_ONLY)
 			RenderDirectX();
+#endif
 			break;
 		default:
 			break;
@@ -96,6 +181,9 @@ namespace dae
 	}
 	void Renderer::CycleRenderStyle()
 	{
+#if defined(SOFTWARE_ONLY)
+		std::cout << RED << "DirectX is not available in this build\n" << RESET;
+#else
 		m_RenderStyle = static_cast<RenderingStyle>((static_cast<int>(m_RenderStyle) + 1) % (static_cast<int>(RenderingStyle::DirectX) + 1));
 
 		std::cout << RED;
@@ -114,15 +202,38 @@ namespace dae
 		}
 
 		std::cout << RESET;
+#endif
 	}
 	void Renderer::CycleCullModes()
 	{
+		m_CullMode = static_cast<CullMode>((static_cast<int>(m_CullMode) + 1) % (static_cast<int>(CullMode::Back) + 1));
+
 		std::cout << RED;
 
-		for (auto& mesh : m_vecMeshes)
+		std::cout << "Switched Cullmode to ";
+		switch (m_CullMode)
+		{
+		case CullMode::Off:
+			std::cout << "Off\n";
+			break;
+		case CullMode::Front:
+			std::cout << "Front\n";
+			break;
+		case CullMode::Back:
+			std::cout << "Back\n";
+			break;
+		default:
+			break;
+		}
+
+#if !defined(SOFTWARE_ONLY)
+		//Only the vehicle, the fire stays double sided
+		//Set on the effect, the mesh may not be published yet
+		if (!m_vecEffects.empty())
 		{
-			mesh->CycleCullMode();
+			m_vecEffects.front()->SetCullMode(m_CullMode);
 		}
+#endif
 
 		std::cout << RESET;
 	}
@@ -166,6 +277,7 @@ namespace dae
 		std::cout << "[Key Bindings - SHARED]" << '\n';
 		std::cout << '\t' << "[F1]"		<< '\t' << "Toggle Rasterizer Mode"				<< '\t' << '\t' << "(HARDWARE/SOFTWARE)"						<< '\n';
 		std::cout << '\t' << "[F2]"		<< '\t' << "Toggle Vehicle Rotation"			<< '\t' << '\t' << "(ON/OFF)"									<< '\n';
+		std::cout << '\t' << "[F4]"		<< '\t' << "Cycle Sampler State"				<< '\t' << '\t' << "(POINT/BILINEAR/TRILINEAR/ANISOTROPIC)"		<< '\n';
 		std::cout << '\t' << "[F9]"		<< '\t' << "Cycle CullMode"						<< '\t' << '\t' << '\t' << "(BACK/FRONT/NONE)"					<< '\n';
 		std::cout << '\t' << "[F10]"	<< '\t' << "Toggle Uniform ClearColor"			<< '\t'			<< "(ON/OFF)"									<< '\n';
 		std::cout << '\t' << "[F11]"	<< '\t' << "Toggle Print FPS"					<< '\t' << '\t' << "(OF/OFF)"									<< '\n';
@@ -174,7 +286,6 @@ namespace dae
 		std::cout << GREEN; // set console Green
 		std::cout << "[Key Bindings - HARDWARE]" << '\n';
 		std::cout << '\t' << "[F3]"		<< '\t' << "Toggle FireFX"						<< '\t' << '\t' << '\t' << "(ON/OFF)"							<< '\n';
-		std::cout << '\t' << "[F4]"		<< '\t' << "Cycle Sampler State"				<< '\t' << '\t' << "(POINT/LINEAR/ANISOTROPIC)"					<< '\n';
 		std::cout << '\n';
 
 		std::cout << Purple; // set console Purple
@@ -183,270 +294,1292 @@ namespace dae
 		std::cout << '\t' << "[F6]"		<< '\t' << "Toggle NormalMap"					<< '\t' << '\t' << "(ON/OFF)"									<< '\n';
 		std::cout << '\t' << "[F7]"		<< '\t' << "Toggle DepthBuffer Visual"			<< '\t'			<< "(BACK/FRONT/NONE)"							<< '\n';
 		std::cout << '\t' << "[F8]"		<< '\t' << "Toggle BoundingBox Visual"			<< '\t'			<< "(ON/OFF)"									<< '\n';
+		std::cout << '\t' << "[F12]"	<< '\t' << "Cycle Shading Pipeline"				<< '\t' << '\t' << "(FORWARD/DEFERRED/VISIBILITY)"				<< '\n';
 		std::cout << '\n';
 
 		std::cout << RESET; //Reset
 	}
 
 	//Software ------------------------------------------------------------------
+	void Renderer::InitializeSoftwareBuffers()
+	{
+		//Create Buffers
+		if (m_pWindow)
+		{
+			m_pFrontBuffer = SDL_GetWindowSurface(m_pWindow);
+		}
+		m_pBackBuffer = SDL_CreateRGBSurface(0, m_Width, m_Height, 32, 0, 0, 0, 0);
+		m_pBackBufferPixels = (uint32_t*)m_pBackBuffer->pixels;
+
+		m_pDepthBufferPixels = new float[m_Width * m_Height];
+		ResetDepthBuffer();
+
+		m_TileCountX = (m_Width + TILE_SIZE - 1) / TILE_SIZE;
+		m_TileCountY = (m_Height + TILE_SIZE - 1) / TILE_SIZE;
+		m_TileBins.resize(m_TileCountX * m_TileCountY);
+		m_TileLights.resize(m_TileCountX * m_TileCountY);
+		m_TileDepthRanges.resize(m_TileCountX * m_TileCountY);
+	}
+	void Renderer::AllocatePipelineBuffers()
+	{
+		//Forward needs neither, so a renderer that never leaves it never pays for them
+		if (m_ShadingPipeline == ShadingPipeline::Deferred && m_pGBufferPixels == nullptr)
+		{
+			m_pGBufferPixels = new GBufferTexel[m_Width * m_Height];
+		}
+		else if (m_ShadingPipeline == ShadingPipeline::VisibilityBuffer && m_pVisibilityBufferPixels == nullptr)
+		{
+			m_pVisibilityBufferPixels = new uint32_t[m_Width * m_Height];
+		}
+	}
 	void Renderer::InitializeSoftwareMeshes()
 	{
-		m_pNormalTexture	 = Software_Texture::LoadFromFile("Resources/vehicle_normal.png");
-		m_pDiffuseTexture	 = Software_Texture::LoadFromFile("Resources/vehicle_diffuse.png");
-		m_pSpecularTexture	 = Software_Texture::LoadFromFile("Resources/vehicle_specular.png");
-		m_pGlossinessTexture = Software_Texture::LoadFromFile("Resources/vehicle_gloss.png");
+		//Queued before the textures, so the shape shows up with the placeholder material while they decode
+		//The vehicle's slot stays empty until it is published, its instances draw nothing until then
+		m_Meshes.emplace_back();
+		m_pAssetLoader->Load<Mesh>([]() -> Mesh*
+			{
+				//The mesh is transformed every frame, so it keeps its own copy instead of pointing into the mapping
+				MeshCache* pVehicleCache{ MeshCache::Load("Resources/vehicle.obj", true, true) };
+				if (pVehicleCache == nullptr)
+				{
+					std::cout << "parse failed\n";
+					return nullptr;
+				}
+
+				Mesh* pVehicle{ new Mesh{} };
+				pVehicle->vertices.assign(pVehicleCache->GetVertices(), pVehicleCache->GetVertices() + pVehicleCache->GetVertexCount());
+				pVehicle->indices.assign(pVehicleCache->GetIndices(), pVehicleCache->GetIndices() + pVehicleCache->GetIndexCount());
+				pVehicle->lods.assign(pVehicleCache->GetLods(), pVehicleCache->GetLods() + pVehicleCache->GetLodCount());
+				//Meshlets reorder the vertices, the stream is built from the final order
+				MeshOptimizer::BuildMeshlets(pVehicle->vertices, pVehicle->indices, pVehicle->lods, pVehicle->meshlets, pVehicle->lodMeshletOffsets);
+				pVehicle->BuildVertexStream();
+				pVehicle->bounds = pVehicleCache->GetBounds();
+				delete pVehicleCache;
+				return pVehicle;
+			},
+			[this](Mesh* pVehicle)
+			{
+				PublishMesh(0, pVehicle);
+			});
+
+		//Drawn with a flat placeholder until the maps are decoded
+		m_pMaterialTexture = Software_Texture::CreatePlaceholderMaterial(PLACEHOLDER_COLOR);
+		m_pAssetLoader->Load<Software_Texture>([]()
+			{
+				return Software_Texture::LoadMaterial("Resources/vehicle_diffuse.png", "Resources/vehicle_normal.png", "Resources/vehicle_specular.png", "Resources/vehicle_gloss.png");
+			},
+			[this](Software_Texture* pMaterialTexture)
+			{
+				//Failed loads keep the placeholder
+				if (pMaterialTexture == nullptr)
+					return;
+
+				delete m_pMaterialTexture;
+				m_pMaterialTexture = pMaterialTexture;
+			});
+
+		UpdateInstanceShift();
+		m_BatchVertices.resize(INSTANCE_BATCH_SIZE);
+		m_BatchMeshlets.resize(INSTANCE_BATCH_SIZE);
+
+		const Vector3 position{ m_Camera.origin + Vector3{ 0.0f, 0.0f, 50.0f } };
+		const Vector3 scale{ Vector3{ 1.0f, 1.0f, 1.0f } };
+
+		const Vector3 rotation{ };
+		AddInstance(Matrix::CreateScale(scale) * Matrix::CreateRotation(rotation) * Matrix::CreateTranslation(position));
+
+		//Same light as the DirectX effect
+		Light sun{};
+		sun.direction = { 0.577f, -0.577f, 0.577f };
+		sun.direction.Normalize();
+		m_Lights.push_back(sun);
+	}
+	void Renderer::PublishMesh(uint32_t meshIndex, Mesh* pMesh)
+	{
+		if (pMesh == nullptr)
+			return;
+
+		m_Meshes[meshIndex] = std::move(*pMesh);
+		delete pMesh;
+
+		//The bounds of its instances changed from nothing to the mesh's
+		m_IsInstanceBvhDirty = true;
+
+		//Larger index offsets leave less room for the draw index, instances that don't fit anymore are dropped like AddInstance would
+		UpdateInstanceShift();
+		const size_t maxInstanceCount{ CLIPPED_TRIANGLE_BIT >> m_InstanceShift };
+		if (m_Instances.size() > maxInstanceCount)
+		{
+			std::cout << "Dropped " << m_Instances.size() - maxInstanceCount << " instances that don't fit next to mesh " << meshIndex << '\n';
+			m_Instances.resize(maxInstanceCount);
+		}
+	}
+	void Renderer::UpdateInstanceShift()
+	{
+		//Enough bits for the index offsets of the largest mesh, the draw index gets the ones left below CLIPPED_TRIANGLE_BIT
+		size_t maxIndexCount{ 1 };
+		for (const Mesh& mesh : m_Meshes)
+		{
+			maxIndexCount = std::max(maxIndexCount, mesh.indices.size());
+		}
+		m_InstanceShift = 0;
+		while ((size_t{ 1 } << m_InstanceShift) < maxIndexCount)
+		{
+			++m_InstanceShift;
+		}
+	}
+	void Renderer::DeleteSoftwareResources()
+	{
+		delete[] m_pDepthBufferPixels;
+		delete[] m_pGBufferPixels;
+		delete[] m_pVisibilityBufferPixels;
+
+		if (m_pBackBuffer)
+		{
+			SDL_FreeSurface(m_pBackBuffer);
+			m_pBackBuffer = nullptr;
+		}
+
+		delete m_pTexture;
+		m_pTexture = nullptr;
+		
+		delete m_pMaterialTexture;
+		m_pMaterialTexture = nullptr;
+	}
+	void Renderer::UpdateSoftware(float elapsedSec)
+	{
+		if (m_Rotating)
+		{
+			//Every instance turns around its own origin
+			const float rotationSpeed{ 30.f };
+			for (MeshInstance& instance : m_Instances)
+			{
+				instance.RotateY(rotationSpeed * elapsedSec);
+			}
+		}
+	}
+	void Renderer::RenderSoftware()
+	{
+		//@START
+		//Lock BackBuffer
+		SDL_LockSurface(m_pBackBuffer);
+
+		//Forward shades while rasterizing, the other pipelines cull after it so they can use the depth of every tile
+		if (m_ShadingPipeline == ShadingPipeline::Forward)
+		{
+			CullLights();
+		}
+
+		ClearBackground();
+		ResetDepthBuffer();
+		m_ClippedVertices.clear();
+		CullInstances();
+
+		//A batch of instances is transformed in parallel, binned & rasterized before the next one reuses its vertex buffers
+		//Every tile loads & writes back its own part of the depth buffer, so depth carries over from one batch to the next
+		const int instanceCount{ static_cast<int>(m_InstanceOrder.size()) };
+		for (int batchStart{ 0 }; batchStart < instanceCount; batchStart += INSTANCE_BATCH_SIZE)
+		{
+			const int batchSize{ std::min(INSTANCE_BATCH_SIZE, instanceCount - batchStart) };
+			m_BatchStart = batchStart;
+
+			m_ThreadPool.ParallelFor(batchSize, [&](int slot)
+				{
+					const MeshInstance& instance{ m_Instances[m_InstanceOrder[batchStart + slot]] };
+					const Mesh& mesh{ m_Meshes[instance.meshIndex] };
+					CullMeshlets(mesh, m_InstanceLods[batchStart + slot], instance.worldMatrix, m_BatchMeshlets[slot]);
+					VertexTransformationFunction(mesh, instance.worldMatrix, m_BatchMeshlets[slot], m_BatchVertices[slot]);
+				});
+
+			for (std::vector<uint32_t>& bin : m_TileBins)
+			{
+				bin.clear();
+			}
+			for (int slot{ 0 }; slot < batchSize; ++slot)
+			{
+				BinTriangles(batchStart + slot);
+			}
+
+			m_ThreadPool.ParallelFor(m_TileCountX * m_TileCountY, [&](int tileIndex)
+				{
+					RenderTile(tileIndex);
+				});
+		}
+
+		if (m_ShadingPipeline != ShadingPipeline::Forward)
+		{
+			CullLights();
+		}
+
+		//Every visible pixel is shaded exactly once, no matter how many fragments it got
+		if (m_ShadingPipeline == ShadingPipeline::Deferred)
+		{
+			m_ThreadPool.ParallelFor(m_Height, [&](int py)
+				{
+					ShadeGBufferRow(py);
+				});
+		}
+		else if (m_ShadingPipeline == ShadingPipeline::VisibilityBuffer)
+		{
+			m_ThreadPool.ParallelFor(m_Height, [&](int py)
+				{
+					ResolveVisibilityBufferRow(py);
+				});
+		}
+
+		//@END
+		//Update SDL Surface
+		SDL_UnlockSurface(m_pBackBuffer);
+		if (m_pWindow)
+		{
+			SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
+			SDL_UpdateWindowSurface(m_pWindow);
+		}
+	}
+
+	void Renderer::CullInstances()
+	{
+		m_InstanceBounds.resize(m_Instances.size());
+		for (size_t index{ 0 }; index < m_Instances.size(); ++index)
+		{
+			const MeshInstance& instance{ m_Instances[index] };
+			m_InstanceBounds[index] = m_Meshes[instance.meshIndex].bounds.Transformed(instance.worldMatrix);
+		}
+
+		//Instances only move in place, refitting keeps the tree good enough & costs a fraction of a rebuild
+		if (m_IsInstanceBvhDirty)
+		{
+			m_InstanceBvh.Build(m_InstanceBounds);
+			m_IsInstanceBvhDirty = false;
+		}
+		else
+		{
+			m_InstanceBvh.Refit(m_InstanceBounds);
+		}
+
+		//Everything outside the frustum is dropped before any of its vertices get transformed
+		m_InstanceOrder.clear();
+		m_InstanceBvh.Cull(m_Camera.frustum, m_InstanceBounds, m_InstanceOrder);
+
+		//By the view depth of every instance's origin, good enough to have most occluders drawn before what they hide
+		std::vector<float> viewDepths(m_Instances.size());
+		for (const uint32_t index : m_InstanceOrder)
+		{
+			viewDepths[index] = m_Camera.viewMatrix.TransformPoint(m_Instances[index].worldMatrix.GetTranslation()).z;
+		}
+
+		std::stable_sort(m_InstanceOrder.begin(), m_InstanceOrder.end(), [&](uint32_t left, uint32_t right)
+			{
+				return viewDepths[left] < viewDepths[right];
+			});
+
+		m_InstanceLods.resize(m_InstanceOrder.size());
+		for (size_t drawIndex{ 0 }; drawIndex < m_InstanceOrder.size(); ++drawIndex)
+		{
+			const uint32_t index{ m_InstanceOrder[drawIndex] };
+			const Bounds& bounds{ m_InstanceBounds[index] };
+			MeshInstance& instance{ m_Instances[index] };
+			const uint32_t lodCount{ static_cast<uint32_t>(m_Meshes[instance.meshIndex].lods.size()) };
+			instance.lod = MeshLod::Select(m_Camera.GetScreenSize(bounds.center, bounds.radius), lodCount, instance.lod);
+			m_InstanceLods[drawIndex] = instance.lod;
+		}
+	}
+	void Renderer::CullMeshlets(const Mesh& mesh, uint32_t lod, const Matrix& worldMatrix, std::vector<uint32_t>& visibleMeshlets) const
+	{
+		visibleMeshlets.clear();
+
+		//Both tests run in object space, with the frustum & camera position moved there once per instance
+		const Frustum objectFrustum{ m_Camera.frustum.Transformed(worldMatrix) };
+		const Vector3 objectCameraPosition{ Matrix::Inverse(worldMatrix).TransformPoint(m_Camera.origin) };
+
+		//Facing away only matters when back faces are culled
+		const bool cullBackFaces{ m_CullMode == CullMode::Back };
+
+		//Only the level's own meshlets, a mesh without levels has all of them in level 0
+		const uint32_t firstMeshlet{ mesh.lods.empty() ? 0 : mesh.lodMeshletOffsets[lod] };
+		const uint32_t endMeshlet{ mesh.lods.empty() ? static_cast<uint32_t>(mesh.meshlets.size()) : mesh.lodMeshletOffsets[lod + 1] };
+
+		for (uint32_t index{ firstMeshlet }; index < endMeshlet; ++index)
+		{
+			const Meshlet& meshlet{ mesh.meshlets[index] };
+			if (!objectFrustum.IntersectsSphere(meshlet.center, meshlet.radius))
+			{
+				continue;
+			}
+
+			if (cullBackFaces && Vector3::Dot((meshlet.coneApex - objectCameraPosition).Normalized(), meshlet.coneAxis) >= meshlet.coneCutoff)
+			{
+				continue;
+			}
+
+			visibleMeshlets.push_back(index);
+		}
+	}
+	void Renderer::VertexTransformationFunction(const Mesh& mesh, const Matrix& worldMatrix, const std::vector<uint32_t>& visibleMeshlets, VertexStream_Out& out) const
+	{
+		const Matrix worldViewProjectionMatrix{ worldMatrix * m_Camera.viewMatrix * m_Camera.projectionMatrix };
+
+		const VertexStream& in{ mesh.vertexStream };
+
+		const size_t vertexCount{ in.positionX.size() };
+		for (std::vector<float>* pComponent : { &out.positionX, &out.positionY, &out.positionZ, &out.positionW, &out.normalX, &out.normalY, &out.normalZ,
+			&out.tangentX, &out.tangentY, &out.tangentZ, &out.viewDirectionX, &out.viewDirectionY, &out.viewDirectionZ, &out.worldPositionX, &out.worldPositionY, &out.worldPositionZ })
+		{
+			pComponent->resize(vertexCount);
+		}
+		out.clipFlags.resize(vertexCount);
+
+		//Only the vertices of the visible meshlets, in ranges aligned to the stream padding so every SIMD batch stays full
+		//Meshlets use the vertices in about the order they're stored, so neighbouring ranges mostly merge
+		struct VertexRange
+		{
+			size_t begin{};
+			size_t end{};
+		};
+		thread_local std::vector<VertexRange> ranges{};
+		ranges.clear();
+
+		if (mesh.meshlets.empty())
+		{
+			ranges.push_back({ 0, vertexCount });
+		}
+		for (const uint32_t meshletIndex : visibleMeshlets)
+		{
+			const Meshlet& meshlet{ mesh.meshlets[meshletIndex] };
+			const size_t begin{ meshlet.vertexBegin / VERTEX_STREAM_PADDING * VERTEX_STREAM_PADDING };
+			const size_t end{ (meshlet.vertexEnd + VERTEX_STREAM_PADDING - 1) / VERTEX_STREAM_PADDING * VERTEX_STREAM_PADDING };
+
+			if (!ranges.empty() && begin <= ranges.back().end && end >= ranges.back().begin)
+			{
+				ranges.back().begin = std::min(ranges.back().begin, begin);
+				ranges.back().end = std::max(ranges.back().end, end);
+				continue;
+			}
+			ranges.push_back({ begin, end });
+		}
+
+#if defined(SIMD_ENABLED)
+		for (const VertexRange& range : ranges)
+		{
+			if (m_IsAvx2Supported)
+			{
+				TransformVerticesSimd<8>(in, worldMatrix, worldViewProjectionMatrix, range.begin, range.end, out);
+			}
+			else
+			{
+				TransformVerticesSimd<4>(in, worldMatrix, worldViewProjectionMatrix, range.begin, range.end, out);
+			}
+		}
+#else
+		const float halfWidth{ m_Width * 0.5f };
+		const float halfHeight{ m_Height * 0.5f };
+
+		for (const VertexRange& range : ranges)
+		{
+			for (size_t index{ range.begin }; index < range.end; ++index)
+			{
+				const Vector4 position{ worldViewProjectionMatrix.TransformPoint({ in.positionX[index], in.positionY[index], in.positionZ[index], 1.0f }) };
+				const Vector3 viewDirection{ Vector3{ position.x, position.y, position.z }.Normalized() };
+
+				out.clipFlags[index] = GetClipFlags(position);
+
+				const float invW{ 1 / position.w };
+				out.positionX[index] = (position.x * invW + 1) * halfWidth;
+				out.positionY[index] = (1 - position.y * invW) * halfHeight;
+				out.positionZ[index] = position.z * invW;
+				out.positionW[index] = position.w;
+
+				const Vector3 worldPosition{ worldMatrix.TransformPoint(in.positionX[index], in.positionY[index], in.positionZ[index]) };
+				out.worldPositionX[index] = worldPosition.x;
+				out.worldPositionY[index] = worldPosition.y;
+				out.worldPositionZ[index] = worldPosition.z;
+
+				const Vector3 normal{ worldMatrix.TransformVector(in.normalX[index], in.normalY[index], in.normalZ[index]) };
+				out.normalX[index] = normal.x;
+				out.normalY[index] = normal.y;
+				out.normalZ[index] = normal.z;
+
+				const Vector3 tangent{ worldMatrix.TransformVector(in.tangentX[index], in.tangentY[index], in.tangentZ[index]) };
+				out.tangentX[index] = tangent.x;
+				out.tangentY[index] = tangent.y;
+				out.tangentZ[index] = tangent.z;
+
+				out.viewDirectionX[index] = viewDirection.x;
+				out.viewDirectionY[index] = viewDirection.y;
+				out.viewDirectionZ[index] = viewDirection.z;
+			}
+		}
+#endif
+	}
+	Renderer::ClipVertex Renderer::TransformVertex(const Mesh& mesh, const Matrix& worldMatrix, const Matrix& worldViewProjectionMatrix, size_t vertex) const
+	{
+		//Single vertex version of VertexTransformationFunction, stored in screen space like m_ClippedVertices
+		const VertexStream& in{ mesh.vertexStream };
+
+		ClipVertex transformed{};
+		const Vector4 position{ worldViewProjectionMatrix.TransformPoint({ in.positionX[vertex], in.positionY[vertex], in.positionZ[vertex], 1.0f }) };
+		const Vector3 viewDirection{ Vector3{ position.x, position.y, position.z }.Normalized() };
+
+		const float invW{ 1 / position.w };
+		transformed.position = { (position.x * invW + 1) * m_Width * 0.5f, (1 - position.y * invW) * m_Height * 0.5f, position.z * invW, position.w };
+
+		const Vector3 normal{ worldMatrix.TransformVector(in.normalX[vertex], in.normalY[vertex], in.normalZ[vertex]) };
+		const Vector3 tangent{ worldMatrix.TransformVector(in.tangentX[vertex], in.tangentY[vertex], in.tangentZ[vertex]) };
+		const Vector3 worldPosition{ worldMatrix.TransformPoint(in.positionX[vertex], in.positionY[vertex], in.positionZ[vertex]) };
+
+		const float attributes[ATTRIBUTE_COUNT]
+		{
+			in.u[vertex], in.v[vertex],
+			normal.x, normal.y, normal.z,
+			tangent.x, tangent.y, tangent.z,
+			viewDirection.x, viewDirection.y, viewDirection.z,
+			worldPosition.x, worldPosition.y, worldPosition.z
+		};
+		std::copy(std::begin(attributes), std::end(attributes), transformed.attributes);
+		return transformed;
+	}
+	uint16_t Renderer::GetClipFlags(const Vector4& position)
+	{
+		const float guardBandW{ position.w * GUARD_BAND };
+
+		uint16_t clipFlags{};
+		clipFlags |= position.x < -position.w ? CLIP_LEFT : 0;
+		clipFlags |= position.x > position.w ? CLIP_RIGHT : 0;
+		clipFlags |= position.y < -position.w ? CLIP_BOTTOM : 0;
+		clipFlags |= position.y > position.w ? CLIP_TOP : 0;
+		clipFlags |= position.z < position.w * NEAR_CLIP_DEPTH ? CLIP_NEAR : 0;
+		clipFlags |= position.z > position.w ? CLIP_FAR : 0;
+		clipFlags |= position.x < -guardBandW ? CLIP_GUARD_BAND_LEFT : 0;
+		clipFlags |= position.x > guardBandW ? CLIP_GUARD_BAND_RIGHT : 0;
+		clipFlags |= position.y < -guardBandW ? CLIP_GUARD_BAND_BOTTOM : 0;
+		clipFlags |= position.y > guardBandW ? CLIP_GUARD_BAND_TOP : 0;
+		return clipFlags;
+	}
+	void Renderer::CullLights()
+	{
+		for (std::vector<uint32_t>& tileLights : m_TileLights)
+		{
+			tileLights.clear();
+		}
+
+		//Once the depth buffer is final, lights entirely in front of or behind a tile's depth range are dropped as well
+		const bool useDepthRanges{ m_ShadingPipeline != ShadingPipeline::Forward };
+		if (useDepthRanges)
+		{
+			m_ThreadPool.ParallelFor(m_TileCountX * m_TileCountY, [&](int tileIndex)
+				{
+					const TileRect tile{ GetTileRect(tileIndex) };
+
+					//Uncovered pixels hold FLT_MAX, a tile without any keeps an empty range
+					TileDepthRange range{ FLT_MAX, 0.f };
+					for (int py{ tile.minY }; py < tile.maxY; ++py)
+					{
+						for (int px{ tile.minX }; px < tile.maxX; ++px)
+						{
+							const float depth{ m_pDepthBufferPixels[px + py * m_Width] };
+							if (depth != FLT_MAX)
+							{
+								range.minDepth = std::min(range.minDepth, depth);
+								range.maxDepth = std::max(range.maxDepth, depth);
+							}
+						}
+					}
+					m_TileDepthRanges[tileIndex] = range;
+				});
+		}
+
+		const Matrix& viewMatrix{ m_Camera.viewMatrix };
+		const Matrix& projectionMatrix{ m_Camera.projectionMatrix };
+		const float halfWidth{ m_Width * 0.5f };
+		const float halfHeight{ m_Height * 0.5f };
+
+		for (uint32_t lightIndex{ 0 }; lightIndex < m_Lights.size(); ++lightIndex)
+		{
+			const Light& light{ m_Lights[lightIndex] };
+
+			//Directional lights & spheres crossing the near plane cover the whole screen
+			int minTileX{ 0 };
+			int minTileY{ 0 };
+			int maxTileX{ m_TileCountX - 1 };
+			int maxTileY{ m_TileCountY - 1 };
+			float minDepth{ -FLT_MAX };
+			float maxDepth{ FLT_MAX };
+
+			if (light.type != LightType::Directional)
+			{
+				const Vector3 center{ viewMatrix.TransformPoint(light.position) };
+				const float radius{ light.range };
+
+				if (center.z + radius < m_Camera.nearPlane)
+				{
+					continue;
+				}
+
+				//NDC depth is z * P22 + P32 over z, which only grows with z
+				const float nearestZ{ std::max(center.z - radius, m_Camera.nearPlane) };
+				minDepth = projectionMatrix[2][2] + projectionMatrix[3][2] / nearestZ;
+				maxDepth = projectionMatrix[2][2] + projectionMatrix[3][2] / (center.z + radius);
+
+				if (center.z - radius > m_Camera.nearPlane)
+				{
+					//x / z & y / z over the box around the sphere peak at its corners, which bounds the projected sphere
+					const float nearZ{ center.z - radius };
+					const float farZ{ center.z + radius };
+					const float minX{ projectionMatrix[0][0] * std::min((center.x - radius) / nearZ, (center.x - radius) / farZ) };
+					const float maxX{ projectionMatrix[0][0] * std::max((center.x + radius) / nearZ, (center.x + radius) / farZ) };
+					const float minY{ projectionMatrix[1][1] * std::min((center.y - radius) / nearZ, (center.y - radius) / farZ) };
+					const float maxY{ projectionMatrix[1][1] * std::max((center.y + radius) / nearZ, (center.y + radius) / farZ) };
+
+					//Same viewport transform as the vertices, y flips
+					const float left{ (minX + 1) * halfWidth };
+					const float right{ (maxX + 1) * halfWidth };
+					const float top{ (1 - maxY) * halfHeight };
+					const float bottom{ (1 - minY) * halfHeight };
+
+					if (right < 0.f || left >= m_Width || bottom < 0.f || top >= m_Height)
+					{
+						continue;
+					}
+
+					minTileX = static_cast<int>(std::max(left, 0.f)) / TILE_SIZE;
+					minTileY = static_cast<int>(std::max(top, 0.f)) / TILE_SIZE;
+					maxTileX = static_cast<int>(std::min(right, m_Width - 1.f)) / TILE_SIZE;
+					maxTileY = static_cast<int>(std::min(bottom, m_Height - 1.f)) / TILE_SIZE;
+				}
+			}
+
+			for (int tileY{ minTileY }; tileY <= maxTileY; ++tileY)
+			{
+				for (int tileX{ minTileX }; tileX <= maxTileX; ++tileX)
+				{
+					const int tileIndex{ tileX + tileY * m_TileCountX };
+					if (useDepthRanges && (m_TileDepthRanges[tileIndex].minDepth > maxDepth || m_TileDepthRanges[tileIndex].maxDepth < minDepth))
+					{
+						continue;
+					}
+
+					m_TileLights[tileIndex].push_back(lightIndex);
+				}
+			}
+		}
+	}
+	void Renderer::BinTriangles(int drawIndex)
+	{
+		const MeshInstance& instance{ m_Instances[m_InstanceOrder[drawIndex]] };
+		const Mesh& mesh{ m_Meshes[instance.meshIndex] };
+		const VertexStream_Out& vertices{ m_BatchVertices[drawIndex - m_BatchStart] };
+		const uint32_t drawBits{ static_cast<uint32_t>(drawIndex) << m_InstanceShift };
+
+		//Only needed to get the clip space positions back for the few triangles that get clipped
+		const Matrix worldViewProjectionMatrix{ instance.worldMatrix * m_Camera.viewMatrix * m_Camera.projectionMatrix };
+
+		//Triangle lists are binned a meshlet at a time, only the ones that survived culling
+		if (!mesh.meshlets.empty())
+		{
+			for (const uint32_t meshletIndex : m_BatchMeshlets[drawIndex - m_BatchStart])
+			{
+				const Meshlet& meshlet{ mesh.meshlets[meshletIndex] };
+				const int endIndex{ static_cast<int>(meshlet.firstIndex + meshlet.triangleCount * TRIANGLE_SIDES) };
+				for (int index{ static_cast<int>(meshlet.firstIndex) }; index < endIndex; index += TRIANGLE_SIDES)
+				{
+					BinTriangle(mesh, vertices, worldViewProjectionMatrix, index, false, drawBits);
+				}
+			}
+			return;
+		}
+
+		//Triangles are binned in submission order so every tile still draws them in that order
+		switch (mesh.primitiveTopology)
+		{
+		case PrimitiveTopology::TriangleList:
+			for (int index{ 0 }; index < static_cast<int>(mesh.indices.size()); index += TRIANGLE_SIDES)
+			{
+				BinTriangle(mesh, vertices, worldViewProjectionMatrix, index, false, drawBits);
+			}
+			break;
+		case PrimitiveTopology::TriangleStrip:
+			for (int index{ 0 }; index < static_cast<int>(mesh.indices.size()) - 2; ++index)
+			{
+				BinTriangle(mesh, vertices, worldViewProjectionMatrix, index, index % 2, drawBits);
+			}
+			break;
+		default:
+			//if this is selected, no topoly is selected -- should not happen
+			break;
+		}
+	}
+	void Renderer::BinTriangle(const Mesh& mesh, const VertexStream_Out& vertices, const Matrix& worldViewProjectionMatrix, int vertexIndex, bool swapVertices, uint32_t drawBits)
+	{
+		const uint32_t vertexIndex0{ mesh.indices[vertexIndex + (2 * swapVertices)] };
+		const uint32_t vertexIndex1{ mesh.indices[vertexIndex + 1] };
+		const uint32_t vertexIndex2{ mesh.indices[vertexIndex + (!swapVertices * 2)] };
+
+		if (vertexIndex0 == vertexIndex1 || vertexIndex1 == vertexIndex2 || vertexIndex2 == vertexIndex0)
+		{
+			return;
+		}
+
+		const uint16_t clipFlags0{ vertices.clipFlags[vertexIndex0] };
+		const uint16_t clipFlags1{ vertices.clipFlags[vertexIndex1] };
+		const uint16_t clipFlags2{ vertices.clipFlags[vertexIndex2] };
+
+		//All three vertices outside the same frustum plane
+		if (clipFlags0 & clipFlags1 & clipFlags2 & CLIP_REJECT_MASK)
+		{
+			return;
+		}
+
+		const uint16_t clipFlags{ static_cast<uint16_t>((clipFlags0 | clipFlags1 | clipFlags2) & CLIP_MASK) };
+		if (clipFlags)
+		{
+			ClipTriangle(mesh, vertices, worldViewProjectionMatrix, { vertexIndex0, vertexIndex1, vertexIndex2 }, clipFlags);
+			return;
+		}
+
+		const Vector2 vertex0{ vertices.positionX[vertexIndex0], vertices.positionY[vertexIndex0] };
+		const Vector2 vertex1{ vertices.positionX[vertexIndex1], vertices.positionY[vertexIndex1] };
+		const Vector2 vertex2{ vertices.positionX[vertexIndex2], vertices.positionY[vertexIndex2] };
+
+		BinScreenTriangle(vertex0, vertex1, vertex2, drawBits | static_cast<uint32_t>(vertexIndex));
+	}
+	void Renderer::BinScreenTriangle(const Vector2& vertex0, const Vector2& vertex1, const Vector2& vertex2, uint32_t binEntry)
+	{
+		//Front faces have a positive signed area, zero area triangles cover nothing whatever the cull mode
+		const float area{ Vector2::Cross(vertex1 - vertex0, vertex2 - vertex1) };
+		if (area == 0.f || (m_CullMode == CullMode::Back && area < 0.f) || (m_CullMode == CullMode::Front && area > 0.f))
+		{
+			return;
+		}
+
+		const Vector2 topLeft{ Vector2::Min(vertex0, Vector2::Min(vertex1, vertex2)) };
+		const Vector2 bottomRight{ Vector2::Max(vertex0, Vector2::Max(vertex1, vertex2)) };
+
+		//Sub pixel, no pixel (edge functions are evaluated at integer coordinates) falls within the bounds
+		if (std::ceil(topLeft.x) > bottomRight.x || std::ceil(topLeft.y) > bottomRight.y)
+		{
+			return;
+		}
+
+		//Same margin as the bounding box in RenderTriangle
+		const float margin{ 1 };
+
+		const int startX{ static_cast<int>(Clamp(topLeft.x - margin, 0.f, static_cast<float>(m_Width))) };
+		const int startY{ static_cast<int>(Clamp(topLeft.y - margin, 0.f, static_cast<float>(m_Height))) };
+		const int endX{ static_cast<int>(Clamp(bottomRight.x + margin, 0.f, static_cast<float>(m_Width))) };
+		const int endY{ static_cast<int>(Clamp(bottomRight.y + margin, 0.f, static_cast<float>(m_Height))) };
+
+		if (startX >= endX || startY >= endY)
+		{
+			return;
+		}
+
+		for (int tileY{ startY / TILE_SIZE }; tileY <= (endY - 1) / TILE_SIZE; ++tileY)
+		{
+			for (int tileX{ startX / TILE_SIZE }; tileX <= (endX - 1) / TILE_SIZE; ++tileX)
+			{
+				m_TileBins[tileX + tileY * m_TileCountX].push_back(binEntry);
+			}
+		}
+	}
+	void Renderer::ClipTriangle(const Mesh& mesh, const VertexStream_Out& vertices, const Matrix& worldViewProjectionMatrix, const uint32_t (&vertexIndices)[3], uint16_t clipFlags)
+	{
+		//Sutherland-Hodgman in homogeneous clip space, before the perspective divide so w <= 0 never gets divided by
+		//Every plane adds at most one vertex
+		constexpr int MAX_POLYGON_SIZE{ 3 + 6 };
+		ClipVertex polygon[MAX_POLYGON_SIZE]{};
+		ClipVertex clippedPolygon[MAX_POLYGON_SIZE]{};
+		int polygonSize{ 3 };
+
+		const VertexStream& verticesIn{ mesh.vertexStream };
+		for (int index{ 0 }; index < 3; ++index)
+		{
+			const uint32_t vertex{ vertexIndices[index] };
+			polygon[index].position = worldViewProjectionMatrix.TransformPoint({ verticesIn.positionX[vertex], verticesIn.positionY[vertex], verticesIn.positionZ[vertex], 1.0f });
+
+			GetVertexAttributes(mesh, vertices, vertex, polygon[index].attributes);
+		}
+
+		//Signed distance to every clip plane, the inside is >= 0
+		const auto getPlaneDistance = [](const Vector4& position, uint16_t plane)
+			{
+				switch (plane)
+				{
+				case CLIP_NEAR:					return position.z - position.w * NEAR_CLIP_DEPTH;
+				case CLIP_FAR:					return position.w - position.z;
+				case CLIP_GUARD_BAND_LEFT:		return position.x + position.w * GUARD_BAND;
+				case CLIP_GUARD_BAND_RIGHT:		return position.w * GUARD_BAND - position.x;
+				case CLIP_GUARD_BAND_BOTTOM:	return position.y + position.w * GUARD_BAND;
+				case CLIP_GUARD_BAND_TOP:		return position.w * GUARD_BAND - position.y;
+				default:						return 0.f;
+				}
+			};
+
+		for (const uint16_t plane : { CLIP_NEAR, CLIP_FAR, CLIP_GUARD_BAND_LEFT, CLIP_GUARD_BAND_RIGHT, CLIP_GUARD_BAND_BOTTOM, CLIP_GUARD_BAND_TOP })
+		{
+			if ((clipFlags & plane) == 0)
+			{
+				continue;
+			}
+
+			int clippedSize{ 0 };
+			for (int index{ 0 }; index < polygonSize; ++index)
+			{
+				const ClipVertex& current{ polygon[index] };
+				const ClipVertex& next{ polygon[(index + 1) % polygonSize] };
+
+				const float currentDistance{ getPlaneDistance(current.position, plane) };
+				const float nextDistance{ getPlaneDistance(next.position, plane) };
+
+				if (currentDistance >= 0.f)
+				{
+					clippedPolygon[clippedSize++] = current;
+				}
+
+				//Edge crosses the plane, clip space is still linear so every attribute is lerped with the same t
+				if ((currentDistance >= 0.f) != (nextDistance >= 0.f))
+				{
+					const float t{ currentDistance / (currentDistance - nextDistance) };
+
+					ClipVertex& intersection{ clippedPolygon[clippedSize++] };
+					intersection.position = current.position + (next.position - current.position) * t;
+					for (int attribute{ 0 }; attribute < ATTRIBUTE_COUNT; ++attribute)
+					{
+						intersection.attributes[attribute] = Lerpf(current.attributes[attribute], next.attributes[attribute], t);
+					}
+				}
+			}
+
+			polygonSize = clippedSize;
+			if (polygonSize < 3)
+			{
+				return;
+			}
+			std::copy(clippedPolygon, clippedPolygon + polygonSize, polygon);
+		}
+
+		//Perspective divide & viewport transform, same as VertexTransformationFunction
+		const float halfWidth{ m_Width * 0.5f };
+		const float halfHeight{ m_Height * 0.5f };
+		for (int index{ 0 }; index < polygonSize; ++index)
+		{
+			Vector4& position{ polygon[index].position };
+			const float invW{ 1 / position.w };
+			position.x = (position.x * invW + 1) * halfWidth;
+			position.y = (1 - position.y * invW) * halfHeight;
+			position.z = position.z * invW;
+		}
+
+		//Fan triangulation keeps the winding of the original triangle
+		for (int index{ 1 }; index < polygonSize - 1; ++index)
+		{
+			const uint32_t clippedTriangle{ static_cast<uint32_t>(m_ClippedVertices.size() / 3) };
+			m_ClippedVertices.push_back(polygon[0]);
+			m_ClippedVertices.push_back(polygon[index]);
+			m_ClippedVertices.push_back(polygon[index + 1]);
+
+			const Vector4& position0{ polygon[0].position };
+			const Vector4& position1{ polygon[index].position };
+			const Vector4& position2{ polygon[index + 1].position };
+			BinScreenTriangle({ position0.x, position0.y }, { position1.x, position1.y }, { position2.x, position2.y }, clippedTriangle | CLIPPED_TRIANGLE_BIT);
+		}
+	}
+	Renderer::TileRect Renderer::GetTileRect(int tileIndex) const
+	{
+		const int tileX{ tileIndex % m_TileCountX };
+		const int tileY{ tileIndex / m_TileCountX };
+
+		TileRect tile{};
+		tile.minX = tileX * TILE_SIZE;
+		tile.minY = tileY * TILE_SIZE;
+		tile.maxX = std::min(tile.minX + TILE_SIZE, m_Width);
+		tile.maxY = std::min(tile.minY + TILE_SIZE, m_Height);
+		return tile;
+	}
+	void Renderer::RenderTile(int tileIndex) const
+	{
+		//Nothing of this batch lands here, the depth buffer already holds the tile's depth
+		if (m_TileBins[tileIndex].empty())
+		{
+			return;
+		}
+
+		//Depth is tested against a small buffer owned by the worker, which stays in cache for the whole tile
+		thread_local TileDepthBuffer tileDepth{};
+		std::fill(std::begin(tileDepth.depth), std::end(tileDepth.depth), FLT_MAX);
+
+		const TileRect tile{ GetTileRect(tileIndex) };
+		for (int py{ tile.minY }; py < tile.maxY; ++py)
+		{
+			const float* pRow{ m_pDepthBufferPixels + tile.minX + py * m_Width };
+			std::copy(pRow, pRow + (tile.maxX - tile.minX), tileDepth.depth + (py - tile.minY) * TILE_SIZE);
+		}
+
+		//Earlier batches may have written the loaded depth, every block's max is computed again the first time it's needed
+		std::fill(std::begin(tileDepth.blockMaxDepth), std::end(tileDepth.blockMaxDepth), FLT_MAX);
+		tileDepth.dirtyBlocks = ~0ull;
+
+		for (const uint32_t binEntry : m_TileBins[tileIndex])
+		{
+			RenderTriangle(binEntry, tile, tileDepth);
+		}
+
+		//Write back so the full depth buffer stays valid after the frame
+		for (int py{ tile.minY }; py < tile.maxY; ++py)
+		{
+			const float* pTileRow{ tileDepth.depth + (py - tile.minY) * TILE_SIZE };
+			std::copy(pTileRow, pTileRow + (tile.maxX - tile.minX), m_pDepthBufferPixels + tile.minX + py * m_Width);
+		}
+	}
+	void Renderer::GetTriangleVertices(uint32_t binEntry, TriangleVertices& triangle) const
+	{
+		//Either a triangle of the mesh, or one the clipper made while binning
+		if (binEntry & CLIPPED_TRIANGLE_BIT)
+		{
+			triangle.pClippedVertices = &m_ClippedVertices[(binEntry & ~CLIPPED_TRIANGLE_BIT) * 3];
+			for (int index{ 0 }; index < 3; ++index)
+			{
+				triangle.positions[index] = triangle.pClippedVertices[index].position;
+			}
+			return;
+		}
+
+		const int drawIndex{ static_cast<int>(binEntry >> m_InstanceShift) };
+		const uint32_t indexOffset{ binEntry & ((1u << m_InstanceShift) - 1) };
+		const MeshInstance& instance{ m_Instances[m_InstanceOrder[drawIndex]] };
+		const Mesh& mesh{ m_Meshes[instance.meshIndex] };
+		triangle.pMesh = &mesh;
+
+		const bool swapVertices{ mesh.primitiveTopology == PrimitiveTopology::TriangleStrip && (indexOffset % 2) };
+		triangle.vertexIndices[0] = mesh.indices[indexOffset + (2 * swapVertices)];
+		triangle.vertexIndices[1] = mesh.indices[indexOffset + 1];
+		triangle.vertexIndices[2] = mesh.indices[indexOffset + (!swapVertices * 2)];
+
+		const int slot{ drawIndex - m_BatchStart };
+		if (slot >= 0 && slot < INSTANCE_BATCH_SIZE)
+		{
+			const VertexStream_Out& vertices{ m_BatchVertices[slot] };
+			triangle.pVertices = &vertices;
+			for (int index{ 0 }; index < 3; ++index)
+			{
+				const size_t vertex{ triangle.vertexIndices[index] };
+				triangle.positions[index] = { vertices.positionX[vertex], vertices.positionY[vertex], vertices.positionZ[vertex], vertices.positionW[vertex] };
+			}
+			return;
+		}
+
+		//The visibility resolve runs after the last batch, earlier instances only get the vertices of their visible triangles transformed again
+		const Matrix worldViewProjectionMatrix{ instance.worldMatrix * m_Camera.viewMatrix * m_Camera.projectionMatrix };
+		for (int index{ 0 }; index < 3; ++index)
+		{
+			triangle.transformedVertices[index] = TransformVertex(mesh, instance.worldMatrix, worldViewProjectionMatrix, triangle.vertexIndices[index]);
+			triangle.positions[index] = triangle.transformedVertices[index].position;
+		}
+		triangle.pClippedVertices = triangle.transformedVertices;
+	}
+	void Renderer::SetupTriangle(const TriangleVertices& triangle, int startX, int startY, TriangleSetup& setup)
+	{
+		const Vector4 (&positions)[3]{ triangle.positions };
+
+		const Vector2 vertex0{ positions[0].x, positions[0].y };
+		const Vector2 vertex1{ positions[1].x, positions[1].y };
+		const Vector2 vertex2{ positions[2].x, positions[2].y };
+
+		const Vector2 edge0{ vertex1 - vertex0 };
+		const Vector2 edge1{ vertex2 - vertex1 };
+		const Vector2 edge2{ vertex0 - vertex2 };
+
+		//Culling happened while binning, triangles left with a negative area are seen from the back
+		//Flipping the edge functions makes them cover their pixels, dividing by -area keeps the weights the same
+		const float area{ Vector2::Cross(edge0, edge1) };
+		const float windingSign{ area < 0.f ? -1.f : 1.f };
+
+		//Edge equations, set up once per triangle: E(p) = Cross(edge, p - edgeStart)
+		//Each one is the (unnormalized) weight of the vertex opposite to its edge, so coverage and weights share them
+		//Stepping one pixel right adds -edge.y, one pixel down adds edge.x
+		const Vector2 startPixel{ static_cast<float>(startX), static_cast<float>(startY) };
+
+		setup.startX = startX;
+		setup.startY = startY;
+
+		setup.edgeFunctionStart[0] = windingSign * Vector2::Cross(edge1, startPixel - vertex1);
+		setup.edgeFunctionStart[1] = windingSign * Vector2::Cross(edge2, startPixel - vertex2);
+		setup.edgeFunctionStart[2] = windingSign * Vector2::Cross(edge0, startPixel - vertex0);
 
+		setup.edgeFunctionStepX[0] = windingSign * -edge1.y;
+		setup.edgeFunctionStepX[1] = windingSign * -edge2.y;
+		setup.edgeFunctionStepX[2] = windingSign * -edge0.y;
 
-		Utils::ParseOBJ("Resources/vehicle.obj", m_Mesh.vertices, m_Mesh.indices);
-		const Vector3 position{ m_Camera.origin + Vector3{ 0.0f, 0.0f, 50.0f } };
-		const Vector3 scale{ Vector3{ 1.0f, 1.0f, 1.0f } };
+		setup.edgeFunctionStepY[0] = windingSign * edge1.x;
+		setup.edgeFunctionStepY[1] = windingSign * edge2.x;
+		setup.edgeFunctionStepY[2] = windingSign * edge0.x;
 
-		const Vector3 rotation{ };
-		m_Mesh.worldMatrix = Matrix::CreateScale(scale) * Matrix::CreateRotation(rotation) * Matrix::CreateTranslation(position);
+		setup.invArea = windingSign / area;
+
+		//Per vertex values used by the interpolation, divided once instead of per pixel
+		for (int index{ 0 }; index < 3; ++index)
+		{
+			setup.invDepth[index] = 1.f / positions[index].z;
+			setup.invW[index] = 1.f / positions[index].w;
+		}
 	}
-	void Renderer::DeleteSoftwareResources()
+	void Renderer::GetVertexAttributes(const Mesh& mesh, const VertexStream_Out& vertices, size_t vertex, float (&attributes)[ATTRIBUTE_COUNT])
 	{
-		delete[] m_pDepthBufferPixels;
+		const VertexStream& verticesIn{ mesh.vertexStream };
 
-		delete m_pTexture;
-		m_pTexture = nullptr;
-		
-		delete m_pNormalTexture;
-		m_pNormalTexture = nullptr;
-		
-		delete m_pDiffuseTexture;
-		m_pDiffuseTexture = nullptr;
-		
-		delete m_pSpecularTexture;
-		m_pSpecularTexture = nullptr;
-		
-		delete m_pGlossinessTexture;
-		m_pGlossinessTexture = nullptr;
+		const float vertexAttributes[ATTRIBUTE_COUNT]
+		{
+			verticesIn.u[vertex], verticesIn.v[vertex],
+			vertices.normalX[vertex], vertices.normalY[vertex], vertices.normalZ[vertex],
+			vertices.tangentX[vertex], vertices.tangentY[vertex], vertices.tangentZ[vertex],
+			vertices.viewDirectionX[vertex], vertices.viewDirectionY[vertex], vertices.viewDirectionZ[vertex],
+			vertices.worldPositionX[vertex], vertices.worldPositionY[vertex], vertices.worldPositionZ[vertex]
+		};
+		std::copy(std::begin(vertexAttributes), std::end(vertexAttributes), attributes);
 	}
-	void Renderer::UpdateSoftware(const Timer* pTimer)
+	void Renderer::SetupAttributes(const TriangleVertices& triangle, TriangleSetup& setup) const
 	{
-		if (m_Rotating)
+		for (int index{ 0 }; index < 3; ++index)
 		{
-			const float rotationSpeed{ 30.f };
-			m_Mesh.RotateY(rotationSpeed * pTimer->GetElapsed());
+			if (triangle.pClippedVertices)
+			{
+				std::copy(std::begin(triangle.pClippedVertices[index].attributes), std::end(triangle.pClippedVertices[index].attributes), setup.attributes[index]);
+				continue;
+			}
+
+			GetVertexAttributes(*triangle.pMesh, *triangle.pVertices, triangle.vertexIndices[index], setup.attributes[index]);
+		}
+
+		for (int index{ 0 }; index < 3; ++index)
+		{
+			const float weightStepX{ setup.edgeFunctionStepX[index] * setup.invArea * setup.invW[index] };
+			const float weightStepY{ setup.edgeFunctionStepY[index] * setup.invArea * setup.invW[index] };
+
+			setup.invWStep[0] += weightStepX;
+			setup.invWStep[1] += weightStepY;
+			setup.uOverWStep[0] += weightStepX * setup.attributes[index][0];
+			setup.uOverWStep[1] += weightStepY * setup.attributes[index][0];
+			setup.vOverWStep[0] += weightStepX * setup.attributes[index][1];
+			setup.vOverWStep[1] += weightStepY * setup.attributes[index][1];
 		}
 	}
-	void Renderer::RenderSoftware()
+	void Renderer::RenderTriangle(uint32_t binEntry, const TileRect& tile, TileDepthBuffer& tileDepth) const
 	{
-		//@START
-		//Lock BackBuffer
-		SDL_LockSurface(m_pBackBuffer);
-		VertexTransformationFunction(m_Mesh);
+		TriangleVertices triangle{};
+		GetTriangleVertices(binEntry, triangle);
 
-		std::vector<Vector2> verticesScreenSpace;
-		for (const auto& ndcVertex : m_Mesh.vertices_out)
-		{
-			Vector2 vertex;
-			vertex.x = ((ndcVertex.position.x + 1) / 2) * m_Width;
-			vertex.y = ((1 - ndcVertex.position.y) / 2) * m_Height;
+		const Vector4 (&positions)[3]{ triangle.positions };
+		const Vector2 vertex0{ positions[0].x, positions[0].y };
+		const Vector2 vertex1{ positions[1].x, positions[1].y };
+		const Vector2 vertex2{ positions[2].x, positions[2].y };
 
-			verticesScreenSpace.push_back(vertex);
-		}
+		//bounding box
+		Vector2 topLeft{ Vector2::Min(vertex0, Vector2::Min(vertex1, vertex2)) };
+		Vector2 bottomRight{ Vector2::Max(vertex0, Vector2::Max(vertex1, vertex2)) };
 
-		ResetDepthBuffer();
-		ClearBackground();
+		const float margin{ 1 };
+
+		topLeft.x = Clamp(topLeft.x - margin, static_cast<float>(tile.minX), static_cast<float>(tile.maxX));
+		topLeft.y = Clamp(topLeft.y - margin, static_cast<float>(tile.minY), static_cast<float>(tile.maxY));
+		bottomRight.x = Clamp(bottomRight.x + margin, static_cast<float>(tile.minX), static_cast<float>(tile.maxX));
+		bottomRight.y = Clamp(bottomRight.y + margin, static_cast<float>(tile.minY), static_cast<float>(tile.maxY));
+
+		const int startX{ static_cast<int>(topLeft.x) };
+		const int endX{ static_cast<int>(bottomRight.x) };
+
+		const int startY{ static_cast<int>(topLeft.y) };
+		const int endY{ static_cast<int>(bottomRight.y) };
 
-		switch (m_Mesh.primitiveTopology)
+		if (m_ShowBoundingBox)
 		{
-		case PrimitiveTopology::TriangleList:
-			for (int index{ 0 }; index < m_Mesh.indices.size(); index += TRIANGLE_SIDES)
-			{
-				RenderTriangle(m_Mesh, verticesScreenSpace, index, false);
-			}
-			break;
-		case PrimitiveTopology::TriangleStrip:
-			for (int index{ 0 }; index < m_Mesh.indices.size() - 2; ++index)
+			const uint32_t white{ SDL_MapRGB(m_pBackBuffer->format, 255, 255, 255) };
+			for (int py{ startY }; py < endY; ++py)
 			{
-				RenderTriangle(m_Mesh, verticesScreenSpace, index, index % 2);
+				std::fill(m_pBackBufferPixels + startX + py * m_Width, m_pBackBufferPixels + endX + py * m_Width, white);
 			}
-			break;
-		default:
-			//if this is selected, no topoly is selected -- should not happen
-			break;
+			return;
 		}
 
+		//Interpolated depth lies between the vertex depths, clipping keeps them all in front of the camera
+		const float minDepth{ std::min(positions[0].z, std::min(positions[1].z, positions[2].z)) };
 
-		//@END
-		//Update SDL Surface
-		SDL_UnlockSurface(m_pBackBuffer);
-		SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
-		SDL_UpdateWindowSurface(m_pWindow);
-	}
-
-	void Renderer::VertexTransformationFunction(Mesh& mesh)
-	{
-		Matrix worldViewProjectionMatrix{ mesh.worldMatrix * m_Camera.viewMatrix * m_Camera.projectionMatrix };
-
-		mesh.vertices_out.clear();
-		mesh.vertices_out.reserve(mesh.vertices.size());
+		uint64_t overlappedBlocks{};
+		const uint64_t occludedBlocks{ GetOccludedBlocks(tileDepth, tile, startX, endX, startY, endY, minDepth, overlappedBlocks) };
 
-		for (const Vertex& v : mesh.vertices)
+		//Hidden behind what the tile already holds, reject before any setup
+		if (occludedBlocks == overlappedBlocks)
 		{
-			Vertex_Out vertex_out{ Vector4{}, v.color, v.uv, v.normal, v.tangent };
+			return;
+		}
 
-			vertex_out.position = worldViewProjectionMatrix.TransformPoint({ v.position, 1.0f });
-			vertex_out.viewDirection = Vector3{ vertex_out.position.x, vertex_out.position.y, vertex_out.position.z }.Normalized();
+		TriangleSetup setup{};
+		SetupTriangle(triangle, startX, startY, setup);
 
-			vertex_out.normal = mesh.worldMatrix.TransformVector(v.normal);
-			vertex_out.tangent = mesh.worldMatrix.TransformVector(v.tangent);
+		setup.endX = endX;
+		setup.endY = endY;
+		setup.occludedBlocks = occludedBlocks;
+		setup.binEntry = binEntry;
 
-			const float invVw{ 1 / vertex_out.position.w };
-			vertex_out.position.x *= invVw;
-			vertex_out.position.y *= invVw;
-			vertex_out.position.z *= invVw;
+		//The visibility buffer only needs depth, attributes are fetched again for the visible pixels
+		if (m_ShadingPipeline != ShadingPipeline::VisibilityBuffer)
+		{
+			SetupAttributes(triangle, setup);
+		}
 
-			mesh.vertices_out.emplace_back(vertex_out);
+#if defined(SIMD_ENABLED)
+		if (m_IsAvx2Supported)
+		{
+			RasterizeTriangleSimd<8>(setup, tile, tileDepth);
+		}
+		else
+		{
+			RasterizeTriangleSimd<4>(setup, tile, tileDepth);
 		}
+#else
+		RasterizeTriangle(setup, tile, tileDepth);
+#endif
 	}
-	void Renderer::RenderTriangle(const Mesh& mesh, const std::vector<Vector2>& screenSpaceVertices, int vertexIndex, bool swapVertices)
+	uint64_t Renderer::GetOccludedBlocks(TileDepthBuffer& tileDepth, const TileRect& tile, int startX, int endX, int startY, int endY, float minDepth, uint64_t& overlappedBlocks) const
 	{
-		const size_t vertexIndex0{ mesh.indices[vertexIndex + (2 * swapVertices)] };
-		const size_t vertexIndex1{ mesh.indices[vertexIndex + 1] };
-		const size_t vertexIndex2{ mesh.indices[vertexIndex + (!swapVertices * 2)] };
+		uint64_t occludedBlocks{};
+		overlappedBlocks = 0;
 
-		if (vertexIndex0 == vertexIndex1 || vertexIndex1 == vertexIndex2 || vertexIndex2 == vertexIndex0)
-		{
-			return;
-		}
+		const int startBlockX{ (startX - tile.minX) / DEPTH_BLOCK_SIZE };
+		const int endBlockX{ (endX - 1 - tile.minX) / DEPTH_BLOCK_SIZE };
+		const int startBlockY{ (startY - tile.minY) / DEPTH_BLOCK_SIZE };
+		const int endBlockY{ (endY - 1 - tile.minY) / DEPTH_BLOCK_SIZE };
 
-		const Vector2 vertex0{ screenSpaceVertices[vertexIndex0] };
-		const Vector2 vertex1{ screenSpaceVertices[vertexIndex1] };
-		const Vector2 vertex2{ screenSpaceVertices[vertexIndex2] };
+		for (int blockY{ startBlockY }; blockY <= endBlockY; ++blockY)
+		{
+			for (int blockX{ startBlockX }; blockX <= endBlockX; ++blockX)
+			{
+				const int blockIndex{ blockX + blockY * DEPTH_BLOCKS_PER_ROW };
+				const uint64_t blockBit{ 1ull << blockIndex };
+				overlappedBlocks |= blockBit;
 
-		const Vector2 edge0{ vertex1 - vertex0 };
-		const Vector2 edge1{ vertex2 - vertex1 };
-		const Vector2 edge2{ vertex0 - vertex2 };
+				//Only pays for the refresh when the block can't already be rejected with its old, higher max
+				float& blockMaxDepth{ tileDepth.blockMaxDepth[blockIndex] };
+				if (minDepth <= blockMaxDepth && (tileDepth.dirtyBlocks & blockBit))
+				{
+					const int minX{ tile.minX + blockX * DEPTH_BLOCK_SIZE };
+					const int minY{ tile.minY + blockY * DEPTH_BLOCK_SIZE };
+					const int maxX{ std::min(minX + DEPTH_BLOCK_SIZE, tile.maxX) };
+					const int maxY{ std::min(minY + DEPTH_BLOCK_SIZE, tile.maxY) };
 
+					blockMaxDepth = 0.f;
+					for (int py{ minY }; py < maxY; ++py)
+					{
+						const float* pRow{ tileDepth.depth + (py - tile.minY) * TILE_SIZE };
+						blockMaxDepth = std::max(blockMaxDepth, *std::max_element(pRow + (minX - tile.minX), pRow + (maxX - tile.minX)));
+					}
+					tileDepth.dirtyBlocks &= ~blockBit;
+				}
 
-		const float area{ Vector2::Cross(edge0, edge1) };
-		const float invArea{ 1 / area };
+				if (minDepth > blockMaxDepth)
+				{
+					occludedBlocks |= blockBit;
+				}
+			}
+		}
 
-		//bounding box
-		Vector2 topLeft{ Vector2::Min(vertex0, Vector2::Min(vertex1, vertex2)) };
-		Vector2 bottomRight{ Vector2::Max(vertex0, Vector2::Max(vertex1, vertex2)) };
+		return occludedBlocks;
+	}
+	Vertex_Out Renderer::InterpolatePixel(const TriangleSetup& setup, float weight0, float weight1, float weight2)
+	{
+		Vertex_Out pixel{};
 
-		const float margin{ 1 };
+		const float interpolatedWDepth{ 1.f / (weight0 * setup.invW[0] + weight1 * setup.invW[1] + weight2 * setup.invW[2]) };
 
-		topLeft.x = Clamp(topLeft.x - margin, 0.f, static_cast<float>(m_Width));
-		topLeft.y = Clamp(topLeft.y - margin, 0.f, static_cast<float>(m_Height));
-		bottomRight.x = Clamp(bottomRight.x + margin, 0.f, static_cast<float>(m_Width));
-		bottomRight.y = Clamp(bottomRight.y + margin, 0.f, static_cast<float>(m_Height));
+		//Perspective correct weights
+		const float correctedWeight0{ weight0 * setup.invW[0] * interpolatedWDepth };
+		const float correctedWeight1{ weight1 * setup.invW[1] * interpolatedWDepth };
+		const float correctedWeight2{ weight2 * setup.invW[2] * interpolatedWDepth };
 
-		const int startX{ static_cast<int>(topLeft.x) };
-		const int endX{ static_cast<int>(bottomRight.x) };
+		float interpolated[ATTRIBUTE_COUNT]{};
+		for (int attribute{ 0 }; attribute < ATTRIBUTE_COUNT; ++attribute)
+		{
+			interpolated[attribute] = correctedWeight0 * setup.attributes[0][attribute] + correctedWeight1 * setup.attributes[1][attribute] + correctedWeight2 * setup.attributes[2][attribute];
+		}
 
-		const int startY{ static_cast<int>(topLeft.y) };
-		const int endY{ static_cast<int>(bottomRight.y) };
+		pixel.uv = { interpolated[0], interpolated[1] };
+		pixel.uvDerivativeX = Vector2{ setup.uOverWStep[0] - pixel.uv.x * setup.invWStep[0], setup.vOverWStep[0] - pixel.uv.y * setup.invWStep[0] } * interpolatedWDepth;
+		pixel.uvDerivativeY = Vector2{ setup.uOverWStep[1] - pixel.uv.x * setup.invWStep[1], setup.vOverWStep[1] - pixel.uv.y * setup.invWStep[1] } * interpolatedWDepth;
+		pixel.normal = Vector3{ interpolated[2], interpolated[3], interpolated[4] }.Normalized();
+		pixel.tangent = Vector3{ interpolated[5], interpolated[6], interpolated[7] }.Normalized();
+		pixel.viewDirection = Vector3{ interpolated[8], interpolated[9], interpolated[10] }.Normalized();
+		pixel.worldPosition = { interpolated[11], interpolated[12], interpolated[13] };
 
-		for (int px{ startX }; px < endX; ++px)
+		return pixel;
+	}
+	void Renderer::RasterizeTriangle(const TriangleSetup& setup, const TileRect& tile, TileDepthBuffer& tileDepth) const
+	{
+		for (int py{ setup.startY }; py < setup.endY; ++py)
 		{
-			for (int py{ startY }; py < endY; ++py)
+			const float rowOffset{ static_cast<float>(py - setup.startY) };
+
+			float edgeFunction0{ setup.edgeFunctionStart[0] + setup.edgeFunctionStepY[0] * rowOffset };
+			float edgeFunction1{ setup.edgeFunctionStart[1] + setup.edgeFunctionStepY[1] * rowOffset };
+			float edgeFunction2{ setup.edgeFunctionStart[2] + setup.edgeFunctionStepY[2] * rowOffset };
+
+			for (int px{ setup.startX }; px < setup.endX; ++px, edgeFunction0 += setup.edgeFunctionStepX[0], edgeFunction1 += setup.edgeFunctionStepX[1], edgeFunction2 += setup.edgeFunctionStepX[2])
 			{
-				Vector2 currentPixel{ static_cast<float>(px), static_cast<float>(py) };
+				const uint64_t blockBit{ 1ull << GetDepthBlockIndex(px, py, tile) };
+				if ((setup.occludedBlocks & blockBit) || edgeFunction0 < 0 || edgeFunction1 < 0 || edgeFunction2 < 0)
+				{
+					continue;
+				}
+
 				const int pixelIndex{ px + py * m_Width };
+				const int tileDepthIndex{ (px - tile.minX) + (py - tile.minY) * TILE_SIZE };
 
-				if (m_ShowBoundingBox)
-				{
-					m_pBackBufferPixels[pixelIndex] = SDL_MapRGB(m_pBackBuffer->format,
-						static_cast<uint8_t>(255),
-						static_cast<uint8_t>(255),
-						static_cast<uint8_t>(255));
+				//Calculate weights
+				const float weight0{ edgeFunction0 * setup.invArea };
+				const float weight1{ edgeFunction1 * setup.invArea };
+				const float weight2{ edgeFunction2 * setup.invArea };
 
+				const float interpolatedZDepth{ 1.f / (weight0 * setup.invDepth[0] + weight1 * setup.invDepth[1] + weight2 * setup.invDepth[2]) };
+
+				if (tileDepth.depth[tileDepthIndex] < interpolatedZDepth)
+				{
 					continue;
 				}
 
-				bool hitTriangle{ Utils::IsInTriangle(currentPixel, vertex0, vertex1, vertex2) };
-				if (hitTriangle)
+				tileDepth.depth[tileDepthIndex] = interpolatedZDepth;
+				tileDepth.dirtyBlocks |= blockBit;
+
+				if (m_ShadingPipeline == ShadingPipeline::VisibilityBuffer)
 				{
-					//Calculate weights
-					float weight0{ Vector2::Cross((currentPixel - vertex1), vertex1 - vertex2) };
-					float weight1{ Vector2::Cross((currentPixel - vertex2), vertex2 - vertex0) };
-					float weight2{ Vector2::Cross((currentPixel - vertex0), vertex0 - vertex1) };
+					m_pVisibilityBufferPixels[pixelIndex] = setup.binEntry;
+					continue;
+				}
+
+				Vertex_Out pixel{ InterpolatePixel(setup, weight0, weight1, weight2) };
 
-					weight0 *= invArea;
-					weight1 *= invArea;
-					weight2 *= invArea;
+				if (m_ShowDepthBuffer)
+				{
+					const float depthColor{ Remap(interpolatedZDepth, 0.985f, 1.0f) };
+					pixel.color = { depthColor, depthColor, depthColor };
+				}
 
-					const float depth0{ mesh.vertices_out[vertexIndex0].position.z };
-					const float depth1{ mesh.vertices_out[vertexIndex1].position.z };
-					const float depth2{ mesh.vertices_out[vertexIndex2].position.z };
+				OutputPixel(pixelIndex, pixel);
+			}
+		}
+	}
 
-					const float interpolatedZDepth{ 1.f / (weight0 * (1.f / depth0) + weight1 * (1.f / depth1) + weight2 * (1.f / depth2)) };
+	void Renderer::OutputPixel(int pixelIndex, const Vertex_Out& pixel) const
+	{
+		//Later fragments that pass the depth test simply overwrite the G-buffer, only the closest one gets shaded
+		if (m_ShadingPipeline == ShadingPipeline::Deferred)
+		{
+			GBufferTexel& texel{ m_pGBufferPixels[pixelIndex] };
+			texel.uv = pixel.uv;
+			texel.uvDerivativeX = pixel.uvDerivativeX;
+			texel.uvDerivativeY = pixel.uvDerivativeY;
+			GBufferTexel::PackDirection(pixel.normal, texel.normal);
+			GBufferTexel::PackDirection(pixel.tangent, texel.tangent);
+			return;
+		}
 
-					if (m_pDepthBufferPixels[pixelIndex] < interpolatedZDepth)
-					{
-						continue;
-					}
+		PixelShading(pixelIndex, pixel);
+	}
+	void Renderer::ShadeGBufferRow(int py) const
+	{
+		//NDC depth is P22 + P32 / w & w is the view space z, the projection scales x & y by P00 & P11
+		const Matrix& projectionMatrix{ m_Camera.projectionMatrix };
+		const float invProjection00{ 1.f / projectionMatrix[0][0] };
+		const float invProjection11{ 1.f / projectionMatrix[1][1] };
+		const float ndcY{ 1.f - py / (m_Height * 0.5f) };
+		const float invHalfWidth{ 1.f / (m_Width * 0.5f) };
+
+		for (int px{ 0 }; px < m_Width; ++px)
+		{
+			//Nothing was drawn here, the background stays
+			const int pixelIndex{ px + py * m_Width };
+			const float depth{ m_pDepthBufferPixels[pixelIndex] };
+			if (depth == FLT_MAX)
+			{
+				continue;
+			}
 
-					m_pDepthBufferPixels[pixelIndex] = interpolatedZDepth;
+			const GBufferTexel& texel{ m_pGBufferPixels[pixelIndex] };
 
+			Vertex_Out pixel{};
+			pixel.uv = texel.uv;
+			pixel.uvDerivativeX = texel.uvDerivativeX;
+			pixel.uvDerivativeY = texel.uvDerivativeY;
+			pixel.normal = GBufferTexel::UnpackDirection(texel.normal);
+			pixel.tangent = GBufferTexel::UnpackDirection(texel.tangent);
 
-					Vertex_Out pixel{};
+			//Same pixel position the raster pass sampled at, the view direction is the direction of the clip position like in the vertex transform
+			const float ndcX{ px * invHalfWidth - 1.f };
+			const Vector3 clipDirection{ ndcX, ndcY, depth };
+			pixel.viewDirection = clipDirection * (1.f / std::sqrt(clipDirection.SqrMagnitude()));
 
-					const float interpolatedWDepth{ 1.f / (weight0 * (1.f / mesh.vertices_out[vertexIndex0].position.w) + weight1 * (1.f / mesh.vertices_out[vertexIndex1].position.w) + weight2 * (1.f / mesh.vertices_out[vertexIndex2].position.w)) };
+			const float viewZ{ projectionMatrix[3][2] / (depth - projectionMatrix[2][2]) };
+			const Vector3 viewPosition{ ndcX * viewZ * invProjection00, ndcY * viewZ * invProjection11, viewZ };
+			pixel.worldPosition = m_Camera.invViewMatrix.TransformPoint(viewPosition);
 
-					const Vector2 UV
-					{
-						(
-							weight0 * mesh.vertices_out[vertexIndex0].uv / mesh.vertices_out[vertexIndex0].position.w +
-							weight1 * mesh.vertices_out[vertexIndex1].uv / mesh.vertices_out[vertexIndex1].position.w +
-							weight2 * mesh.vertices_out[vertexIndex2].uv / mesh.vertices_out[vertexIndex2].position.w
-						) * interpolatedWDepth
-					};
+			if (m_ShowDepthBuffer)
+			{
+				const float depthColor{ Remap(depth, 0.985f, 1.0f) };
+				pixel.color = { depthColor, depthColor, depthColor };
+			}
 
+			PixelShading(pixelIndex, pixel);
+		}
+	}
+	void Renderer::ResolveVisibilityBufferRow(int py) const
+	{
+		//Neighbouring pixels mostly belong to the same triangle, its setup is only redone when the id changes
+		TriangleSetup setup{};
+		bool hasSetup{ false };
 
-					const Vector3 normal
-					{
-						(
-							weight0 * mesh.vertices_out[vertexIndex0].normal / mesh.vertices_out[vertexIndex0].position.w +
-							weight1 * mesh.vertices_out[vertexIndex1].normal / mesh.vertices_out[vertexIndex1].position.w +
-							weight2 * mesh.vertices_out[vertexIndex2].normal / mesh.vertices_out[vertexIndex2].position.w
-						) * interpolatedWDepth
-					};
-
-					const Vector3 tangent
-					{
-						(
-							weight0 * mesh.vertices_out[vertexIndex0].tangent / mesh.vertices_out[vertexIndex0].position.w +
-							weight1 * mesh.vertices_out[vertexIndex1].tangent / mesh.vertices_out[vertexIndex1].position.w +
-							weight2 * mesh.vertices_out[vertexIndex2].tangent / mesh.vertices_out[vertexIndex2].position.w
-						) * interpolatedWDepth
-					};
-
-					const Vector3 viewDirection
-					{
-						(
-							weight0 * mesh.vertices_out[vertexIndex0].viewDirection / mesh.vertices_out[vertexIndex0].position.w +
-							weight1 * mesh.vertices_out[vertexIndex1].viewDirection / mesh.vertices_out[vertexIndex1].position.w +
-							weight2 * mesh.vertices_out[vertexIndex2].viewDirection / mesh.vertices_out[vertexIndex2].position.w
-						) * interpolatedWDepth
-					};
+		for (int px{ 0 }; px < m_Width; ++px)
+		{
+			const int pixelIndex{ px + py * m_Width };
+			const float depth{ m_pDepthBufferPixels[pixelIndex] };
+			if (depth == FLT_MAX)
+			{
+				continue;
+			}
 
-					pixel.uv = UV;
-					pixel.normal = normal.Normalized();
-					pixel.tangent = tangent.Normalized();
-					pixel.viewDirection = viewDirection.Normalized();
+			const uint32_t binEntry{ m_pVisibilityBufferPixels[pixelIndex] };
+			if (!hasSetup || binEntry != setup.binEntry)
+			{
+				TriangleVertices triangle{};
+				GetTriangleVertices(binEntry, triangle);
+
+				setup = {};
+				SetupTriangle(triangle, px, py, setup);
+				SetupAttributes(triangle, setup);
+				setup.binEntry = binEntry;
+				hasSetup = true;
+			}
 
+			//Same edge functions the raster pass evaluated at this pixel
+			const float offsetX{ static_cast<float>(px - setup.startX) };
+			const float weight0{ (setup.edgeFunctionStart[0] + setup.edgeFunctionStepX[0] * offsetX) * setup.invArea };
+			const float weight1{ (setup.edgeFunctionStart[1] + setup.edgeFunctionStepX[1] * offsetX) * setup.invArea };
+			const float weight2{ (setup.edgeFunctionStart[2] + setup.edgeFunctionStepX[2] * offsetX) * setup.invArea };
 
-					if (m_ShowDepthBuffer)
-					{
-						const float depthColor{ Remap(interpolatedZDepth, 0.985f, 1.0f) };
-						pixel.color = { depthColor, depthColor, depthColor };
-					}
+			Vertex_Out pixel{ InterpolatePixel(setup, weight0, weight1, weight2) };
 
-					PixelShading(px + (py * m_Width), pixel);
-				}
+			if (m_ShowDepthBuffer)
+			{
+				const float depthColor{ Remap(depth, 0.985f, 1.0f) };
+				pixel.color = { depthColor, depthColor, depthColor };
 			}
+
+			PixelShading(pixelIndex, pixel);
 		}
 	}
-
 	void Renderer::PixelShading(int pixelIndex, const Vertex_Out& pixel) const
 	{
+		const TextureSample material{ m_pMaterialTexture->Sample(pixel.uv, pixel.uvDerivativeX, pixel.uvDerivativeY, m_FilteringMethod) };
+		const ColorRGB diffuseColor{ material.GetColor(Software_Texture::MATERIAL_DIFFUSE) };
+		const float specularColor{ material.channels[Software_Texture::MATERIAL_SPECULAR] };
+		const float glossiness{ material.channels[Software_Texture::MATERIAL_GLOSSINESS] };
+
 		Vector3 pixelNormal{ pixel.normal };
 
 		if (m_IsNormalMapEnabled)
@@ -454,52 +1587,88 @@ namespace dae
 			const Vector3 binormal{ Vector3::Cross(pixel.normal, pixel.tangent) };
 			const Matrix tangentSpaceAxis{ Matrix{pixel.tangent, binormal, pixel.normal, Vector3::Zero} };
 
-			const ColorRGB normalMap{ (2 * m_pNormalTexture->Sample(pixel.uv)) - ColorRGB{1,1,1} };
+			const ColorRGB normalMap{ (2 * material.GetColor(Software_Texture::MATERIAL_NORMAL)) - ColorRGB{1,1,1} };
 			const Vector3 normalSample{ normalMap.r, normalMap.g, normalMap.b };
 			pixelNormal = tangentSpaceAxis.TransformVector(normalSample);
 		}
 
-		Vector3 lightDirection{ 0.577f, -0.577f, 0.577f };
-		lightDirection.Normalize();
-
-		const float lightIntensity{ 7.f };
+		//The diffuse strength of the original single light, light intensities scale diffuse & specular alike on top of it
+		const float diffuseReflectance{ 7.f };
 		const float specularShinyValue{ 25.f };
+		const float specularExp{ specularShinyValue * glossiness };
+		const ColorRGB lambert{ LightingUtils::Lambert(diffuseReflectance, diffuseColor) };
+		const Vector3 shadingNormal{ pixelNormal.Normalized() };
 
+		//Only the lights that can reach this pixel's tile
+		const int px{ pixelIndex % m_Width };
+		const int py{ pixelIndex / m_Width };
+		const std::vector<uint32_t>& tileLights{ m_TileLights[px / TILE_SIZE + (py / TILE_SIZE) * m_TileCountX] };
 
 		ColorRGB finalColor{};
 
-		const float observedArea{ Vector3::DotClamped(pixelNormal.Normalized(), -lightDirection) };
-
-		switch (m_LightingMode)
-		{
-		case dae::Renderer::LightingMode::Combined:
-		{
-			const ColorRGB lambert{ LightingUtils::Lambert(1.0f, m_pDiffuseTexture->Sample(pixel.uv)) };
-			const float specularExp{ specularShinyValue * m_pGlossinessTexture->Sample(pixel.uv).r };
-			const ColorRGB specular{ m_pSpecularTexture->Sample(pixel.uv) * LightingUtils::Phong(1.0f, specularExp, -lightDirection, pixel.viewDirection, pixelNormal) };
-			finalColor += lightIntensity * observedArea * lambert + specular;
-		}
-		break;
-		case dae::Renderer::LightingMode::ObservedArea:
-		{
-			finalColor += ColorRGB{ observedArea, observedArea, observedArea };
-		}
-		break;
-		case dae::Renderer::LightingMode::Diffuse:
-		{
-			const ColorRGB lambert{ LightingUtils::Lambert(1.0f, m_pDiffuseTexture->Sample(pixel.uv)) };
-			finalColor += lightIntensity * observedArea * lambert;
-		}
-		break;
-		case dae::Renderer::LightingMode::Specular:
+		for (const uint32_t lightIndex : tileLights)
 		{
-			const float specularExp{ specularShinyValue * m_pGlossinessTexture->Sample(pixel.uv).r };
-			const ColorRGB specular{ m_pSpecularTexture->Sample(pixel.uv) * LightingUtils::Phong(1.0f, specularExp, -lightDirection, pixel.viewDirection, pixelNormal) };
-			finalColor += observedArea * specular;
-		}
-		break;
-		default:
+			const Light& light{ m_Lights[lightIndex] };
+
+			//Direction the light travels towards the pixel & the fraction of it that arrives
+			Vector3 lightDirection{ light.direction };
+			float attenuation{ 1.f };
+
+			if (light.type != LightType::Directional)
+			{
+				const Vector3 toPixel{ pixel.worldPosition - light.position };
+				const float distanceSquared{ toPixel.SqrMagnitude() };
+				const float rangeSquared{ light.range * light.range };
+				if (distanceSquared >= rangeSquared)
+				{
+					continue;
+				}
+
+				lightDirection = toPixel / std::sqrt(distanceSquared);
+
+				//Inverse square, windowed by (1 - (d / range)^4)^2 so it reaches zero at the range
+				const float rangeRatioSquared{ distanceSquared / rangeSquared };
+				const float window{ 1.f - rangeRatioSquared * rangeRatioSquared };
+				attenuation = window * window / std::max(distanceSquared, 0.01f);
+
+				if (light.type == LightType::Spot)
+				{
+					const float cosAngle{ Vector3::Dot(lightDirection, light.direction) };
+					const float cone{ std::clamp((cosAngle - light.cosOuterCone) / std::max(light.cosInnerCone - light.cosOuterCone, 1e-4f), 0.f, 1.f) };
+					attenuation *= cone * cone;
+				}
+			}
+
+			const ColorRGB radiance{ light.color * (light.intensity * attenuation) };
+			const float observedArea{ Vector3::DotClamped(shadingNormal, -lightDirection) };
+
+			switch (m_LightingMode)
+			{
+			case dae::Renderer::LightingMode::Combined:
+			{
+				const ColorRGB specular{ specularColor * LightingUtils::Phong(1.0f, specularExp, -lightDirection, pixel.viewDirection, pixelNormal, m_SpecularPrecision) };
+				finalColor += (observedArea * lambert + specular) * radiance;
+			}
+			break;
+			case dae::Renderer::LightingMode::ObservedArea:
+			{
+				finalColor += ColorRGB{ observedArea, observedArea, observedArea } * radiance;
+			}
+			break;
+			case dae::Renderer::LightingMode::Diffuse:
+			{
+				finalColor += (observedArea * lambert) * radiance;
+			}
+			break;
+			case dae::Renderer::LightingMode::Specular:
+			{
+				const ColorRGB specular{ specularColor * LightingUtils::Phong(1.0f, specularExp, -lightDirection, pixel.viewDirection, pixelNormal, m_SpecularPrecision) };
+				finalColor += (observedArea * specular) * radiance;
+			}
 			break;
+			default:
+				break;
+			}
 		}
 
 		if (m_ShowDepthBuffer)
@@ -560,6 +1729,30 @@ namespace dae
 
 		std::cout << RESET;
 	}
+	void Renderer::CycleShadingPipeline()
+	{
+		std::cout << GREEN;
+
+		m_ShadingPipeline = static_cast<ShadingPipeline>((static_cast<int>(m_ShadingPipeline) + 1) % (static_cast<int>(ShadingPipeline::VisibilityBuffer) + 1));
+		AllocatePipelineBuffers();
+		std::cout << "Shading pipeline set to: ";
+		switch (m_ShadingPipeline)
+		{
+		case ShadingPipeline::Forward:
+			std::cout << "Forward\n";
+			break;
+		case ShadingPipeline::Deferred:
+			std::cout << "Deferred\n";
+			break;
+		case ShadingPipeline::VisibilityBuffer:
+			std::cout << "Visibility buffer\n";
+			break;
+		default:
+			break;
+		}
+
+		std::cout << RESET;
+	}
 	void Renderer::ToggleNormalMap()
 	{
 		std::cout << GREEN;
@@ -613,6 +1806,7 @@ namespace dae
 	}
 
 	//DirectX --------------------------------------------------------------------
+#if !defined(SOFTWARE_ONLY)
 	HRESULT Renderer::InitializeDirectX()
 	{
 		//1. Create Device & DeviceContext
@@ -730,44 +1924,88 @@ namespace dae
 	}
 	void Renderer::InitializeDirectXMeshes()
 	{
-		std::vector<Vertex> vertices;
-		std::vector<uint32_t> indices;
+		//Effects are compiled up front with placeholder maps, the meshes & textures follow from the loader
+		Effect_Shaded* pShadedEffect = new Effect_Shaded(m_pDevice, L"Resources/PosTex3D.fx");
+		pShadedEffect->SetCullMode(m_CullMode);
 
-		//Vehicle
-		bool parse{ Utils::ParseOBJ("Resources/vehicle.obj", vertices, indices) };
-		if (parse == false)
-		{
-			std::cout << "parse failed\n";
-		}
+		DirectX_Texture placeholderDiffuse{ PLACEHOLDER_COLOR, 1.f, m_pDevice };
+		DirectX_Texture placeholderNormal{ ColorRGB{ 0.5f, 0.5f, 1.f }, 1.f, m_pDevice };
+		DirectX_Texture placeholderBlack{ ColorRGB{ 0.f, 0.f, 0.f }, 1.f, m_pDevice };
 
-		Effect_Shaded* pShadedEffect = new Effect_Shaded(m_pDevice, L"Resources/PosTex3D.fx");
+		pShadedEffect->SetDiffuseMap(&placeholderDiffuse);
+		pShadedEffect->SetNormalMap(&placeholderNormal);
+		pShadedEffect->SetSpeculareMap(&placeholderBlack);
+		pShadedEffect->SetGlossinessMap(&placeholderBlack);
+
+		//The fire stays invisible until its texture is in
+		effect* pEffect = new effect(m_pDevice, L"Resources/Transparency.fx");
+
+		DirectX_Texture placeholderFire{ PLACEHOLDER_COLOR, 0.f, m_pDevice };
+		pEffect->SetDiffuseMap(&placeholderFire);
 
-		DirectX_Texture diffuseTexture{ "Resources/vehicle_diffuse.png",	m_pDevice };
-		DirectX_Texture normalTexture{ "Resources/vehicle_normal.png",		m_pDevice };
-		DirectX_Texture specularTexture{ "Resources/vehicle_specular.png",	m_pDevice };
-		DirectX_Texture glossinessTexture{ "Resources/vehicle_gloss.png",		m_pDevice };
+		m_vecEffects = { pShadedEffect, pEffect };
+		m_vecMeshes = { nullptr, nullptr };
 
-		pShadedEffect->SetDiffuseMap(&diffuseTexture);
-		pShadedEffect->SetNormalMap(&normalTexture);
-		pShadedEffect->SetSpeculareMap(&specularTexture);
-		pShadedEffect->SetGlossinessMap(&glossinessTexture);
+		//Vehicle, with the same levels of detail as the software path so both share one cache
+		//Meshes are queued before their textures, so the shapes show up with the placeholders while the textures decode
+		m_pAssetLoader->Load<MeshCache>([]() { return MeshCache::Load("Resources/vehicle.obj", true, true); },
+			[this](MeshCache* pCache) { PublishDirectXMesh(0, pCache); });
 
-		m_vecMeshes.push_back(new mesh(m_pDevice, vertices, indices, pShadedEffect));
+		LoadDirectXTexture("Resources/vehicle_diffuse.png", [pShadedEffect](DirectX_Texture* pTexture) { pShadedEffect->SetDiffuseMap(pTexture); });
+		LoadDirectXTexture("Resources/vehicle_normal.png", [pShadedEffect](DirectX_Texture* pTexture) { pShadedEffect->SetNormalMap(pTexture); });
+		LoadDirectXTexture("Resources/vehicle_specular.png", [pShadedEffect](DirectX_Texture* pTexture) { pShadedEffect->SetSpeculareMap(pTexture); });
+		LoadDirectXTexture("Resources/vehicle_gloss.png", [pShadedEffect](DirectX_Texture* pTexture) { pShadedEffect->SetGlossinessMap(pTexture); });
 
 		//Fire
-		Utils::ParseOBJ("Resources/fireFX.obj", vertices, indices);
-		effect* pEffect = new effect(m_pDevice, L"Resources/Transparency.fx");
+		m_pAssetLoader->Load<MeshCache>([]() { return MeshCache::Load("Resources/fireFX.obj"); },
+			[this](MeshCache* pCache) { PublishDirectXMesh(1, pCache); });
+
+		LoadDirectXTexture("Resources/fireFX_diffuse.png", [pEffect](DirectX_Texture* pTexture) { pEffect->SetDiffuseMap(pTexture); });
+	}
+	void Renderer::LoadDirectXTexture(const std::string& path, const std::function<void(DirectX_Texture*)>& setMap)
+	{
+		//Decoded & uploaded on a worker, the device is free threaded
+		ID3D11Device* pDevice{ m_pDevice };
+		m_pAssetLoader->Load<DirectX_Texture>([path, pDevice]() { return new DirectX_Texture{ path, pDevice }; },
+			[setMap](DirectX_Texture* pTexture)
+			{
+				//The effect keeps its own reference to the view, failed loads keep the placeholder
+				if (pTexture && pTexture->GetShaderResourceView())
+				{
+					setMap(pTexture);
+				}
+				delete pTexture;
+			});
+	}
+	void Renderer::PublishDirectXMesh(size_t slot, MeshCache* pCache)
+	{
+		if (pCache == nullptr)
+		{
+			std::cout << "parse failed\n";
+			return;
+		}
 
-		DirectX_Texture fireDiffuseTexture{ "Resources/fireFX_diffuse.png",	m_pDevice };
-		pEffect->SetDiffuseMap(&fireDiffuseTexture);
+		//Buffers are filled straight from the mapped cache, the mesh owns the slot's effect from now on
+		mesh* pMesh{ new mesh(m_pDevice, pCache->GetVertices(), pCache->GetVertexCount(), pCache->GetIndices(), pCache->GetIndexCount(),
+			pCache->GetLods(), pCache->GetLodCount(), pCache->GetBounds(), m_vecEffects[slot]) };
+		delete pCache;
 
-		m_vecMeshes.push_back(new mesh(m_pDevice, vertices, indices, pEffect));
+		pMesh->RotateY(m_DirectXRotation);
+		m_vecMeshes[slot] = pMesh;
 	}
 	void Renderer::DeleteDirectXResources()
 	{
-		for (auto& mesh : m_vecMeshes)
+		//Effects of meshes that never got published have no owner yet
+		for (size_t slot{ 0 }; slot < m_vecMeshes.size(); ++slot)
 		{
-			delete mesh;
+			if (m_vecMeshes[slot])
+			{
+				delete m_vecMeshes[slot];
+			}
+			else
+			{
+				delete m_vecEffects[slot];
+			}
 		}
 
 		//RELEASE RESOURCES IN REVERSED ORDER
@@ -811,20 +2049,21 @@ namespace dae
 	void Renderer::UpdateDirectX(const Timer* pTimer)
 	{
 		const float rotationSpeed{ 30.f };
+		const float rotation{ m_Rotating ? rotationSpeed * TO_RADIANS * pTimer->GetElapsed() : 0.f };
+		m_DirectXRotation += rotation;
 
 		for (auto& mesh : m_vecMeshes)
 		{
-			if (m_Rotating)
-			{
-				mesh->RotateY(rotationSpeed * TO_RADIANS * pTimer->GetElapsed());
-			}
+			if (mesh == nullptr)
+				continue;
 
+			mesh->RotateY(rotation);
 			mesh->UpdateMatrices(m_Camera.GetWorldViewProjection(), m_Camera.GetInvViewMatrix());
 		}
 	}
 	void Renderer::RenderDirectX() const
 	{
-		if (!m_IsInitialized)
+		if (!m_IsInitialized || m_vecMeshes.size() < 2)
 			return;
 
 		//1. CLEAR RTV & DSV
@@ -838,24 +2077,52 @@ namespace dae
 
 
 		//2. SET PIPELINE + INVOKE DRAWCALLS ( = RENDER)
-		m_vecMeshes[0]->Render(m_pDeviceContext); //Vehicle
-		if (m_ShowFire)
+		//Meshes outside the frustum don't get a draw call, the rest draw the level of detail for their size on screen
+		if (m_vecMeshes[0] && m_vecMeshes[0]->IsVisible(m_Camera.frustum))
+		{
+			m_vecMeshes[0]->Render(m_pDeviceContext, m_vecMeshes[0]->SelectLod(m_Camera)); //Vehicle
+		}
+		if (m_ShowFire && m_vecMeshes[1] && m_vecMeshes[1]->IsVisible(m_Camera.frustum))
 		{
-			m_vecMeshes[1]->Render(m_pDeviceContext); //Vehicle
+			m_vecMeshes[1]->Render(m_pDeviceContext, m_vecMeshes[1]->SelectLod(m_Camera)); //Vehicle
 		}
 
 		//3. PRESENT BACKBUFFER (SWAP)
 		m_pSwapChain->Present(0, 0);
 	}
+#endif
 
 	void Renderer::CycleFilteringMethods()
 	{
-		std::cout << Purple;
+		m_FilteringMethod = static_cast<FilteringMethod>((static_cast<int>(m_FilteringMethod) + 1) % (static_cast<int>(FilteringMethod::ANISOTROPIC) + 1));
 
-		for (auto& mesh : m_vecMeshes)
+		std::cout << RED;
+
+		std::cout << "Filtering Method: ";
+		switch (m_FilteringMethod)
+		{
+		case FilteringMethod::POINT:
+			std::cout << "POINT\n";
+			break;
+		case FilteringMethod::BILINEAR:
+			std::cout << "BILINEAR\n";
+			break;
+		case FilteringMethod::TRILINEAR:
+			std::cout << "TRILINEAR\n";
+			break;
+		case FilteringMethod::ANISOTROPIC:
+			std::cout << "ANISOTROPIC\n";
+			break;
+		default:
+			break;
+		}
+
+#if !defined(SOFTWARE_ONLY)
+		for (auto& pEffect : m_vecEffects)
 		{
-			mesh->CycleFilteringMethod();
+			pEffect->SetFilteringMethod(m_FilteringMethod);
 		}
+#endif
 
 		std::cout << RESET;
 	}
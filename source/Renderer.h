@@ -2,8 +2,18 @@
 #include "DataTypes.h"
 
 #include "Utils.h"
-#include "mesh.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
 #include "Camera.h"
+#include "Bvh.h"
+#include "Textures.h"
+#include "ThreadPool.h"
+#include "AssetLoader.h"
+#include "Simd.h"
+
+#if !defined(SOFTWARE_ONLY)
+#include "mesh.h"
+#endif
 
 
 using namespace dae;
@@ -17,6 +27,7 @@ namespace dae
 	{
 	public:
 		Renderer(SDL_Window* pWindow);
+		Renderer(int width, int height); //Headless: software only, renders into the owned back buffer
 		~Renderer();
 
 		Renderer(const Renderer&) = delete;
@@ -27,6 +38,25 @@ namespace dae
 		void Update(const Timer* pTimer);
 		void Render();
 
+		//Assets load in the background & are published at the start of every update, this waits for all of them instead
+		void WaitForAssets();
+
+		//Headless ---------------------------------------
+		void UpdateHeadless(float elapsedSec);
+		void SetCameraTransform(const Vector3& origin, float pitch, float yaw);
+		void SetFilteringMethod(FilteringMethod filteringMethod);
+		void SetShadingPipeline(ShadingPipeline shadingPipeline);
+		void SetSpecularPrecision(SpecularPrecision specularPrecision);
+
+		//Lights of the software shader, starts out with a single directional light
+		void AddLight(const Light& light);
+		void ClearLights();
+
+		//Instances of the software scene, mesh 0 is the vehicle & the scene starts out with a single one of it
+		void AddInstance(const Matrix& worldMatrix, uint32_t meshIndex = 0);
+		void ClearInstances();
+		bool SaveBackBuffer(const std::string& path) const;
+
 		void CycleRenderStyle();				//F1
 		void EnableRotation();					//F2
 		void ToggleFireFx();					//F3
@@ -39,6 +69,7 @@ namespace dae
 		void CycleCullModes();					//F9
 		void ToggleUniformClearColor();			//F10
 		void TogglePrintFPS();					//F11
+		void CycleShadingPipeline();			//F12
 
 		bool PrintFps() const
 		{
@@ -51,7 +82,11 @@ namespace dae
 			Software,
 			DirectX
 		};
+#if defined(SOFTWARE_ONLY)
+		RenderingStyle m_RenderStyle{ RenderingStyle::Software };
+#else
 		RenderingStyle m_RenderStyle{ RenderingStyle::DirectX };
+#endif
 
 		SDL_Window* m_pWindow{};
 
@@ -62,6 +97,15 @@ namespace dae
 		bool m_Rotating{ true };
 		bool m_PrintFPS{ false };
 		bool m_IsUniformColorEnabled{ false };
+		CullMode m_CullMode{ CullMode::Back };
+		FilteringMethod m_FilteringMethod{ FilteringMethod::POINT };
+
+		//Textures & meshes are decoded, parsed & cached on its workers, the ready callbacks hand them over at the start of an update
+		//Deleted before anything else, so no job outlives the device or the renderer
+		AssetLoader* m_pAssetLoader{};
+
+		//Diffuse of the placeholder textures that are drawn until the real ones are in
+		const ColorRGB PLACEHOLDER_COLOR{ 0.5f, 0.5f, 0.5f };
 
 		void PrintInfo() const;
 
@@ -71,6 +115,8 @@ namespace dae
 
 
 		//Software Variables -----------------------------
+		//Checked once, the vertex transform & the rasterizer use the 8 lane versions when it's set
+		const bool m_IsAvx2Supported{ Simd::IsAvx2Supported() };
 		bool m_ShowDepthBuffer{ false };
 		bool m_ShowBoundingBox{ false };
 		bool m_IsNormalMapEnabled{ true };
@@ -83,41 +129,244 @@ namespace dae
 			Specular
 		};
 		LightingMode m_LightingMode{ LightingMode::Combined };
+		SpecularPrecision m_SpecularPrecision{ SpecularPrecision::Fast };
 
 		SDL_Surface* m_pFrontBuffer{ nullptr };
 		SDL_Surface* m_pBackBuffer{ nullptr };
 		uint32_t* m_pBackBufferPixels{};
 
 		float* m_pDepthBufferPixels{};
+
+		//Deferred: attributes of the closest fragment per pixel, only valid where the depth buffer was written
+		//View direction & world position are rebuilt from the depth & the pixel's position
+		//Both buffers are allocated the first time their pipeline is selected
+		ShadingPipeline m_ShadingPipeline{ ShadingPipeline::Forward };
+		GBufferTexel* m_pGBufferPixels{};
+
+		//Visibility buffer: bin entry of the closest triangle per pixel, which is all the raster pass writes next to depth
+		uint32_t* m_pVisibilityBufferPixels{};
 		const int TRIANGLE_SIDES{ 3 };
 
-		Mesh m_Mesh{};
+		//Screen is split in tiles, every tile gets the triangles overlapping it and is rendered by one worker
+		struct TileRect
+		{
+			int minX{};
+			int minY{};
+			int maxX{};
+			int maxY{};
+		};
+		static constexpr int TILE_SIZE{ 64 };
+		int m_TileCountX{};
+		int m_TileCountY{};
+		std::vector<std::vector<uint32_t>> m_TileBins{};
+
+		//Per tile indices into m_Lights, only lights whose range can reach the tile
+		std::vector<Light> m_Lights{};
+		std::vector<std::vector<uint32_t>> m_TileLights{};
+
+		//NDC depth range of the covered pixels of every tile, known before shading in the deferred pipelines
+		struct TileDepthRange
+		{
+			float minDepth{};
+			float maxDepth{};
+		};
+		std::vector<TileDepthRange> m_TileDepthRanges{};
+
+		ThreadPool m_ThreadPool{};
+
+		//Hierarchical depth: every tile keeps the max depth of its 8x8 blocks next to the per pixel depth
+		//A triangle that starts behind a block's max depth can't pass the depth test anywhere in that block
+		static constexpr int DEPTH_BLOCK_SIZE{ 8 };
+		static constexpr int DEPTH_BLOCKS_PER_ROW{ TILE_SIZE / DEPTH_BLOCK_SIZE };
+		static_assert(DEPTH_BLOCKS_PER_ROW * DEPTH_BLOCKS_PER_ROW <= 64, "Depth blocks of a tile must fit in a 64 bit mask");
+
+		struct TileDepthBuffer
+		{
+			//One extra row so the SIMD rasterizer can read a full register past the last pixel of the tile
+			float depth[TILE_SIZE * (TILE_SIZE + 1)]{};
+			float blockMaxDepth[DEPTH_BLOCKS_PER_ROW * DEPTH_BLOCKS_PER_ROW]{};
+
+			//Blocks written to since their max was computed, depth only decreases so the stored max stays a valid bound
+			uint64_t dirtyBlocks{};
+		};
+
+		//Interpolated per pixel, in this order: uv, normal, tangent, viewDirection, worldPosition
+		static constexpr int ATTRIBUTE_COUNT{ 14 };
+		//uv, normal & tangent, the rest are rebuilt from depth when the G-buffer is shaded
+		static constexpr int GBUFFER_ATTRIBUTE_COUNT{ 8 };
+
+		//Per triangle values, set up once and shared by the scalar & SIMD rasterizers
+		struct TriangleSetup
+		{
+			//Gathered from the vertex streams once, so the rasterizers don't touch them per pixel
+			float attributes[3][ATTRIBUTE_COUNT]{};
+
+			int startX{};
+			int endX{};
+			int startY{};
+			int endY{};
+
+			//Edge equations at (startX, startY), edgeFunction[i] is the unnormalized weight of vertex i
+			float edgeFunctionStart[3]{};
+			float edgeFunctionStepX[3]{};
+			float edgeFunctionStepY[3]{};
+			float invArea{};
+
+			float invDepth[3]{};
+			float invW[3]{};
+
+			//1/w, u/w & v/w are linear in screen space, their per pixel steps give the exact uv derivatives of every pixel
+			//[0] steps along x, [1] along y
+			float invWStep[2]{};
+			float uOverWStep[2]{};
+			float vOverWStep[2]{};
+
+			//Bit per depth block of the tile, set when the whole block is in front of the triangle
+			uint64_t occludedBlocks{};
+
+			//Identifies the triangle in the visibility buffer
+			uint32_t binEntry{};
+		};
+
+		//Clipping: every transformed vertex gets an outcode against the frustum & a guard band around it
+		//Triangles outside one frustum plane are rejected, triangles crossing the near, far or guard band planes are clipped while binning
+		//Everything else stays within the guard band, so the rasterizer's float edge functions can't blow up
+		static constexpr uint16_t CLIP_LEFT{ 1 << 0 };
+		static constexpr uint16_t CLIP_RIGHT{ 1 << 1 };
+		static constexpr uint16_t CLIP_BOTTOM{ 1 << 2 };
+		static constexpr uint16_t CLIP_TOP{ 1 << 3 };
+		static constexpr uint16_t CLIP_NEAR{ 1 << 4 };
+		static constexpr uint16_t CLIP_FAR{ 1 << 5 };
+		static constexpr uint16_t CLIP_GUARD_BAND_LEFT{ 1 << 6 };
+		static constexpr uint16_t CLIP_GUARD_BAND_RIGHT{ 1 << 7 };
+		static constexpr uint16_t CLIP_GUARD_BAND_BOTTOM{ 1 << 8 };
+		static constexpr uint16_t CLIP_GUARD_BAND_TOP{ 1 << 9 };
+		static constexpr int CLIP_PLANE_COUNT{ 10 };
+
+		static constexpr uint16_t CLIP_REJECT_MASK{ CLIP_LEFT | CLIP_RIGHT | CLIP_BOTTOM | CLIP_TOP | CLIP_NEAR | CLIP_FAR };
+		static constexpr uint16_t CLIP_MASK{ CLIP_NEAR | CLIP_FAR | CLIP_GUARD_BAND_LEFT | CLIP_GUARD_BAND_RIGHT | CLIP_GUARD_BAND_BOTTOM | CLIP_GUARD_BAND_TOP };
+
+		//Guard band half extent in NDC units, 4 keeps the screen coordinates within 5 screens
+		static constexpr float GUARD_BAND{ 4.f };
+		//Clipped vertices end up just in front of the near plane, so 1 / depth stays finite
+		static constexpr float NEAR_CLIP_DEPTH{ 1e-5f };
+
+		struct ClipVertex
+		{
+			//Clip space while clipping, screen space x & y, NDC depth & w (like VertexStream_Out) once stored
+			Vector4 position{};
+			float attributes[ATTRIBUTE_COUNT]{};
+		};
+
+		//Bin entries with this bit set index m_ClippedVertices (3 per triangle) instead of the mesh indices
+		static constexpr uint32_t CLIPPED_TRIANGLE_BIT{ 1u << 31 };
+		std::vector<ClipVertex> m_ClippedVertices{};
+
+		//Screen space positions of a binned triangle & where its attributes come from
+		struct TriangleVertices
+		{
+			Vector4 positions[3]{};
+			size_t vertexIndices[3]{};
+			const Mesh* pMesh{ nullptr };
+			const VertexStream_Out* pVertices{ nullptr };
+
+			//Set for clipped triangles, or points to transformedVertices when the instance's batch is gone
+			const ClipVertex* pClippedVertices{ nullptr };
+			ClipVertex transformedVertices[3]{};
+		};
+
+		//Scene: meshes are loaded once, every instance places one of them with its own world matrix
+		std::vector<Mesh> m_Meshes{};
+		std::vector<MeshInstance> m_Instances{};
+
+		//World bounds of every instance & a hierarchy over them, rebuilt when instances get added or removed & refit otherwise
+		std::vector<Bounds> m_InstanceBounds{};
+		Bvh m_InstanceBvh{};
+		bool m_IsInstanceBvhDirty{ true };
+
+		//Indices into m_Instances of the instances inside the frustum, sorted front to back so the closest ones fill the depth buffer first
+		std::vector<uint32_t> m_InstanceOrder{};
+
+		//Level of detail every entry of m_InstanceOrder is drawn with, from the size of its bounds on screen
+		std::vector<uint32_t> m_InstanceLods{};
+
+		//Instances are transformed, binned & rasterized a batch at a time, only the current batch keeps its transformed vertices
+		static constexpr int INSTANCE_BATCH_SIZE{ 32 };
+		std::vector<VertexStream_Out> m_BatchVertices{};
+
+		//Meshlets of every batch slot that survived culling, only their vertices get transformed & their triangles binned
+		std::vector<std::vector<uint32_t>> m_BatchMeshlets{};
+		int m_BatchStart{};
+
+		//Bin entries of unclipped triangles hold (draw index << m_InstanceShift) | index offset, the draw index being the position in m_InstanceOrder
+		int m_InstanceShift{};
 
 		Software_Texture* m_pTexture{};
-		Software_Texture* m_pNormalTexture{};
-		Software_Texture* m_pDiffuseTexture{};
-		Software_Texture* m_pSpecularTexture{};
-		Software_Texture* m_pGlossinessTexture{};
+		//Diffuse, normal, specular & glossiness maps interleaved, one fetch per pixel
+		Software_Texture* m_pMaterialTexture{};
 
 		//Software Functions -----------------------------
-		void VertexTransformationFunction(Mesh& mesh);
-		void RenderTriangle(const Mesh& mesh, const std::vector<Vector2>& screenSpaceVertices, int vertexIndex, bool swapVertices);
+		void CullInstances();
+		void CullMeshlets(const Mesh& mesh, uint32_t lod, const Matrix& worldMatrix, std::vector<uint32_t>& visibleMeshlets) const;
+		void VertexTransformationFunction(const Mesh& mesh, const Matrix& worldMatrix, const std::vector<uint32_t>& visibleMeshlets, VertexStream_Out& out) const;
+		ClipVertex TransformVertex(const Mesh& mesh, const Matrix& worldMatrix, const Matrix& worldViewProjectionMatrix, size_t vertex) const;
+		static uint16_t GetClipFlags(const Vector4& position);
+		void CullLights();
+		void BinTriangles(int drawIndex);
+		void BinTriangle(const Mesh& mesh, const VertexStream_Out& vertices, const Matrix& worldViewProjectionMatrix, int vertexIndex, bool swapVertices, uint32_t drawBits);
+		void BinScreenTriangle(const Vector2& vertex0, const Vector2& vertex1, const Vector2& vertex2, uint32_t binEntry);
+		void ClipTriangle(const Mesh& mesh, const VertexStream_Out& vertices, const Matrix& worldViewProjectionMatrix, const uint32_t (&vertexIndices)[3], uint16_t clipFlags);
+		TileRect GetTileRect(int tileIndex) const;
+		void RenderTile(int tileIndex) const;
+		void RenderTriangle(uint32_t binEntry, const TileRect& tile, TileDepthBuffer& tileDepth) const;
+		void GetTriangleVertices(uint32_t binEntry, TriangleVertices& triangle) const;
+		static void SetupTriangle(const TriangleVertices& triangle, int startX, int startY, TriangleSetup& setup);
+		void SetupAttributes(const TriangleVertices& triangle, TriangleSetup& setup) const;
+		static void GetVertexAttributes(const Mesh& mesh, const VertexStream_Out& vertices, size_t vertex, float (&attributes)[ATTRIBUTE_COUNT]);
+		static Vertex_Out InterpolatePixel(const TriangleSetup& setup, float weight0, float weight1, float weight2);
+		void RasterizeTriangle(const TriangleSetup& setup, const TileRect& tile, TileDepthBuffer& tileDepth) const;
+#if defined(SIMD_ENABLED)
+		//Defined in RendererSimd.h, instantiated with the 4 SSE lanes in RendererSse.cpp & the 8 AVX2 lanes in RendererAvx2.cpp
+		template<int LANES>
+		void TransformVerticesSimd(const VertexStream& in, const Matrix& worldMatrix, const Matrix& worldViewProjectionMatrix, size_t begin, size_t end, VertexStream_Out& out) const;
+		template<int LANES>
+		void RasterizeTriangleSimd(const TriangleSetup& setup, const TileRect& tile, TileDepthBuffer& tileDepth) const;
+#endif
+		//Defined here so the SIMD rasterizers in their own files inline it too, it runs for every group of lanes
+		static int GetDepthBlockIndex(int px, int py, const TileRect& tile)
+		{
+			return (px - tile.minX) / DEPTH_BLOCK_SIZE + ((py - tile.minY) / DEPTH_BLOCK_SIZE) * DEPTH_BLOCKS_PER_ROW;
+		}
+		uint64_t GetOccludedBlocks(TileDepthBuffer& tileDepth, const TileRect& tile, int startX, int endX, int startY, int endY, float minDepth, uint64_t& overlappedBlocks) const;
+		void OutputPixel(int pixelIndex, const Vertex_Out& pixel) const;
+		void ShadeGBufferRow(int py) const;
+		void ResolveVisibilityBufferRow(int py) const;
 		void PixelShading(int pixelIndex, const Vertex_Out& pixel) const;
 		
 		void ClearBackground() const;
 		void ResetDepthBuffer();
 
+		void InitializeSoftwareBuffers();
+		void AllocatePipelineBuffers();
 		void InitializeSoftwareMeshes();
+		void PublishMesh(uint32_t meshIndex, Mesh* pMesh);
+		void UpdateInstanceShift();
 		void DeleteSoftwareResources();
-		void UpdateSoftware(const Timer* pTimer);
+		void UpdateSoftware(float elapsedSec);
 		void RenderSoftware();
 
 
 		//DirectX Variables ------------------------------
 		bool m_ShowFire{ true };
 
+#if !defined(SOFTWARE_ONLY)
 		bool m_IsInitialized{ false };		
+		//Vehicle & fire, nullptr until the loader publishes them
 		std::vector<mesh*> m_vecMeshes;
+		//Effect of every mesh slot, holds the placeholder maps until the textures are in & is handed to the mesh once it is
+		std::vector<effect*> m_vecEffects;
+		//Rotation so far, a mesh published late starts at the same angle as the others
+		float m_DirectXRotation{};
 		
 		//DIRECTX
 		HRESULT InitializeDirectX();
@@ -131,9 +380,12 @@ namespace dae
 
 		//DirectX Function -------------------------------
 		void InitializeDirectXMeshes();
+		void LoadDirectXTexture(const std::string& path, const std::function<void(DirectX_Texture*)>& setMap);
+		void PublishDirectXMesh(size_t slot, MeshCache* pCache);
 		void DeleteDirectXResources();
 		void UpdateDirectX(const Timer* pTimer);
 		void RenderDirectX() const;
+#endif
 
 	};
 }
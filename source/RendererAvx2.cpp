@@ -0,0 +1,14 @@
+#include "pch.h"
+
+//The one file built with /arch:AVX2 (-mavx2 -mfma), the renderer only calls into it when Simd::IsAvx2Supported
+//Doesn't use the precompiled header, which is built for the baseline architecture
+#define SIMD_AVX2
+#include "RendererSimd.h"
+
+#if defined(SIMD_ENABLED)
+namespace dae
+{
+	template void Renderer::TransformVerticesSimd<8>(const VertexStream& in, const Matrix& worldMatrix, const Matrix& worldViewProjectionMatrix, size_t begin, size_t end, VertexStream_Out& out) const;
+	template void Renderer::RasterizeTriangleSimd<8>(const TriangleSetup& setup, const TileRect& tile, TileDepthBuffer& tileDepth) const;
+}
+#endif
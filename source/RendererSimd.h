@@ -0,0 +1,294 @@
+#pragma once
+#include "Renderer.h"
+
+//Bodies of the SIMD vertex transform & rasterizer, written against the Simd.h wrappers of whatever width the includer picked
+//Only included by RendererSse.cpp & RendererAvx2.cpp, which each instantiate them for their own width
+//These are the only functions compiled for AVX2, keep them to Simd.h & Renderer members: an inline helper from a shared
+//header that doesn't get inlined here would be emitted with AVX2 instructions and the linker may keep that copy for every caller
+
+#if defined(SIMD_ENABLED)
+namespace dae
+{
+	template<int LANES>
+	void Renderer::TransformVerticesSimd(const VertexStream& in, const Matrix& worldMatrix, const Matrix& worldViewProjectionMatrix, size_t begin, size_t end, VertexStream_Out& out) const
+	{
+		//Simd::WIDTH vertices per iteration, every matrix element is broadcast once up front
+		using namespace Simd;
+		static_assert(LANES == WIDTH, "The instantiation has to match the width Simd.h was included with");
+		static_assert(VERTEX_STREAM_PADDING % WIDTH == 0, "Vertex ranges have to hold whole batches");
+
+		Float viewProjection[4][4]{};
+		Float world[4][3]{};
+		for (int row{ 0 }; row < 4; ++row)
+		{
+			for (int column{ 0 }; column < 4; ++column)
+			{
+				viewProjection[row][column] = Set(worldViewProjectionMatrix[row][column]);
+				if (column < 3)
+				{
+					world[row][column] = Set(worldMatrix[row][column]);
+				}
+			}
+		}
+
+		const Float zero{ Set(0.f) };
+		const Float one{ Set(1.f) };
+		const Float guardBand{ Set(GUARD_BAND) };
+		const Float nearClipDepth{ Set(NEAR_CLIP_DEPTH) };
+		const Float screenHalfWidth{ Set(m_Width * 0.5f) };
+		const Float screenHalfHeight{ Set(m_Height * 0.5f) };
+
+		//begin & end are padded to VERTEX_STREAM_PADDING, so every batch is full
+		for (size_t index{ begin }; index < end; index += WIDTH)
+		{
+			const Float positionX{ Load(&in.positionX[index]) };
+			const Float positionY{ Load(&in.positionY[index]) };
+			const Float positionZ{ Load(&in.positionZ[index]) };
+
+			Float projected[4]{};
+			for (int column{ 0 }; column < 4; ++column)
+			{
+				projected[column] = MulAdd(positionX, viewProjection[0][column], MulAdd(positionY, viewProjection[1][column], MulAdd(positionZ, viewProjection[2][column], viewProjection[3][column])));
+			}
+
+			Float viewDirectionX{ projected[0] };
+			Float viewDirectionY{ projected[1] };
+			Float viewDirectionZ{ projected[2] };
+			Normalize(viewDirectionX, viewDirectionY, viewDirectionZ);
+			Store(&out.viewDirectionX[index], viewDirectionX);
+			Store(&out.viewDirectionY[index], viewDirectionY);
+			Store(&out.viewDirectionZ[index], viewDirectionZ);
+
+			//Outcodes, one lane mask per plane in CLIP_LEFT .. CLIP_GUARD_BAND_TOP order
+			const Float w{ projected[3] };
+			const Float negativeW{ Sub(zero, w) };
+			const Float guardBandW{ Mul(w, guardBand) };
+			const Float negativeGuardBandW{ Sub(zero, guardBandW) };
+			const int planeMasks[CLIP_PLANE_COUNT]
+			{
+				MoveMask(Less(projected[0], negativeW)), MoveMask(Less(w, projected[0])),
+				MoveMask(Less(projected[1], negativeW)), MoveMask(Less(w, projected[1])),
+				MoveMask(Less(projected[2], Mul(w, nearClipDepth))), MoveMask(Less(w, projected[2])),
+				MoveMask(Less(projected[0], negativeGuardBandW)), MoveMask(Less(guardBandW, projected[0])),
+				MoveMask(Less(projected[1], negativeGuardBandW)), MoveMask(Less(guardBandW, projected[1]))
+			};
+			for (int lane{ 0 }; lane < WIDTH; ++lane)
+			{
+				uint16_t clipFlags{};
+				for (int plane{ 0 }; plane < CLIP_PLANE_COUNT; ++plane)
+				{
+					clipFlags |= static_cast<uint16_t>(((planeMasks[plane] >> lane) & 1) << plane);
+				}
+				out.clipFlags[index + lane] = clipFlags;
+			}
+
+			//Perspective divide & viewport transform, only meaningful for vertices that don't need clipping
+			const Float invW{ Div(one, w) };
+			Store(&out.positionX[index], Mul(Add(Mul(projected[0], invW), one), screenHalfWidth));
+			Store(&out.positionY[index], Mul(Sub(one, Mul(projected[1], invW)), screenHalfHeight));
+			Store(&out.positionZ[index], Mul(projected[2], invW));
+			Store(&out.positionW[index], projected[3]);
+
+			Store(&out.worldPositionX[index], MulAdd(positionX, world[0][0], MulAdd(positionY, world[1][0], MulAdd(positionZ, world[2][0], world[3][0]))));
+			Store(&out.worldPositionY[index], MulAdd(positionX, world[0][1], MulAdd(positionY, world[1][1], MulAdd(positionZ, world[2][1], world[3][1]))));
+			Store(&out.worldPositionZ[index], MulAdd(positionX, world[0][2], MulAdd(positionY, world[1][2], MulAdd(positionZ, world[2][2], world[3][2]))));
+
+			const Float normalX{ Load(&in.normalX[index]) };
+			const Float normalY{ Load(&in.normalY[index]) };
+			const Float normalZ{ Load(&in.normalZ[index]) };
+			Store(&out.normalX[index], MulAdd(normalX, world[0][0], MulAdd(normalY, world[1][0], Mul(normalZ, world[2][0]))));
+			Store(&out.normalY[index], MulAdd(normalX, world[0][1], MulAdd(normalY, world[1][1], Mul(normalZ, world[2][1]))));
+			Store(&out.normalZ[index], MulAdd(normalX, world[0][2], MulAdd(normalY, world[1][2], Mul(normalZ, world[2][2]))));
+
+			const Float tangentX{ Load(&in.tangentX[index]) };
+			const Float tangentY{ Load(&in.tangentY[index]) };
+			const Float tangentZ{ Load(&in.tangentZ[index]) };
+			Store(&out.tangentX[index], MulAdd(tangentX, world[0][0], MulAdd(tangentY, world[1][0], Mul(tangentZ, world[2][0]))));
+			Store(&out.tangentY[index], MulAdd(tangentX, world[0][1], MulAdd(tangentY, world[1][1], Mul(tangentZ, world[2][1]))));
+			Store(&out.tangentZ[index], MulAdd(tangentX, world[0][2], MulAdd(tangentY, world[1][2], Mul(tangentZ, world[2][2]))));
+		}
+	}
+	template<int LANES>
+	void Renderer::RasterizeTriangleSimd(const TriangleSetup& setup, const TileRect& tile, TileDepthBuffer& tileDepth) const
+	{
+		//Same steps as RasterizeTriangle, Simd::WIDTH pixels of a row at a time
+		//Lanes that are not covered or fail the depth test are masked out, shading stays per pixel
+		using namespace Simd;
+		static_assert(LANES == WIDTH, "The instantiation has to match the width Simd.h was included with");
+
+		const Float zero{ Set(0.f) };
+		const Float one{ Set(1.f) };
+		const Float laneOffsets{ LaneOffsets() };
+		const Float invArea{ Set(setup.invArea) };
+
+		Float edgeFunctionStepX[3]{};
+		Float edgeFunctionBlockStepX[3]{};
+		Float invDepth[3]{};
+		Float invW[3]{};
+		for (int index{ 0 }; index < 3; ++index)
+		{
+			edgeFunctionStepX[index] = Set(setup.edgeFunctionStepX[index]);
+			edgeFunctionBlockStepX[index] = Set(setup.edgeFunctionStepX[index] * WIDTH);
+			invDepth[index] = Set(setup.invDepth[index]);
+			invW[index] = Set(setup.invW[index]);
+		}
+
+		//Deferred only writes what the G-buffer keeps
+		const int attributeCount{ m_ShadingPipeline == ShadingPipeline::Deferred ? GBUFFER_ATTRIBUTE_COUNT : ATTRIBUTE_COUNT };
+
+		Float attributes[3][ATTRIBUTE_COUNT]{};
+		for (int index{ 0 }; index < 3; ++index)
+		{
+			for (int attribute{ 0 }; attribute < attributeCount; ++attribute)
+			{
+				attributes[index][attribute] = Set(setup.attributes[index][attribute]);
+			}
+		}
+
+		Float invWStep[2]{};
+		Float uOverWStep[2]{};
+		Float vOverWStep[2]{};
+		for (int axis{ 0 }; axis < 2; ++axis)
+		{
+			invWStep[axis] = Set(setup.invWStep[axis]);
+			uOverWStep[axis] = Set(setup.uOverWStep[axis]);
+			vOverWStep[axis] = Set(setup.vOverWStep[axis]);
+		}
+
+		alignas(32) float laneDepth[WIDTH]{};
+		alignas(32) float laneValues[ATTRIBUTE_COUNT][WIDTH]{};
+		alignas(32) float laneUVDerivatives[4][WIDTH]{};
+
+		for (int py{ setup.startY }; py < setup.endY; ++py)
+		{
+			const float rowOffset{ static_cast<float>(py - setup.startY) };
+
+			Float edgeFunction[3]{};
+			for (int index{ 0 }; index < 3; ++index)
+			{
+				const Float rowStart{ Set(setup.edgeFunctionStart[index] + setup.edgeFunctionStepY[index] * rowOffset) };
+				edgeFunction[index] = MulAdd(laneOffsets, edgeFunctionStepX[index], rowStart);
+			}
+
+			for (int px{ setup.startX }; px < setup.endX; px += WIDTH)
+			{
+				const Float edgeFunction0{ edgeFunction[0] };
+				const Float edgeFunction1{ edgeFunction[1] };
+				const Float edgeFunction2{ edgeFunction[2] };
+
+				for (int index{ 0 }; index < 3; ++index)
+				{
+					edgeFunction[index] = Add(edgeFunction[index], edgeFunctionBlockStepX[index]);
+				}
+
+				//A group of lanes touches at most two depth blocks, skip it when both are occluded
+				const uint64_t blockBits{ (1ull << GetDepthBlockIndex(px, py, tile)) | (1ull << GetDepthBlockIndex(std::min(px + WIDTH, setup.endX) - 1, py, tile)) };
+				if ((setup.occludedBlocks & blockBits) == blockBits)
+				{
+					continue;
+				}
+
+				//Coverage, lanes past the end of the bounding box are dropped
+				Float mask{ And(GreaterEqual(edgeFunction0, zero), And(GreaterEqual(edgeFunction1, zero), GreaterEqual(edgeFunction2, zero))) };
+				mask = And(mask, Less(Add(Set(static_cast<float>(px - setup.startX)), laneOffsets), Set(static_cast<float>(setup.endX - setup.startX))));
+
+				if (MoveMask(mask) == 0)
+				{
+					continue;
+				}
+
+				const Float weight0{ Mul(edgeFunction0, invArea) };
+				const Float weight1{ Mul(edgeFunction1, invArea) };
+				const Float weight2{ Mul(edgeFunction2, invArea) };
+
+				const Float interpolatedZDepth{ Div(one, MulAdd(weight0, invDepth[0], MulAdd(weight1, invDepth[1], Mul(weight2, invDepth[2])))) };
+
+				//The tile depth buffer is padded, so reading past the tile is safe and masked lanes write back what they read
+				float* pDepth{ tileDepth.depth + (px - tile.minX) + (py - tile.minY) * TILE_SIZE };
+				const Float storedDepth{ Load(pDepth) };
+
+				mask = And(mask, LessEqual(interpolatedZDepth, storedDepth));
+
+				const int laneMask{ MoveMask(mask) };
+				if (laneMask == 0)
+				{
+					continue;
+				}
+
+				Store(pDepth, Select(mask, interpolatedZDepth, storedDepth));
+				tileDepth.dirtyBlocks |= blockBits;
+
+				if (m_ShadingPipeline == ShadingPipeline::VisibilityBuffer)
+				{
+					uint32_t* pVisibility{ m_pVisibilityBufferPixels + px + py * m_Width };
+					for (int lane{ 0 }; lane < WIDTH; ++lane)
+					{
+						if (laneMask & (1 << lane))
+						{
+							pVisibility[lane] = setup.binEntry;
+						}
+					}
+					continue;
+				}
+
+				//Perspective correct weights
+				const Float interpolatedWDepth{ Div(one, MulAdd(weight0, invW[0], MulAdd(weight1, invW[1], Mul(weight2, invW[2])))) };
+				const Float correctedWeight0{ Mul(Mul(weight0, invW[0]), interpolatedWDepth) };
+				const Float correctedWeight1{ Mul(Mul(weight1, invW[1]), interpolatedWDepth) };
+				const Float correctedWeight2{ Mul(Mul(weight2, invW[2]), interpolatedWDepth) };
+
+				Float interpolated[ATTRIBUTE_COUNT]{};
+				for (int attribute{ 0 }; attribute < attributeCount; ++attribute)
+				{
+					interpolated[attribute] = MulAdd(correctedWeight0, attributes[0][attribute], MulAdd(correctedWeight1, attributes[1][attribute], Mul(correctedWeight2, attributes[2][attribute])));
+				}
+
+				Normalize(interpolated[2], interpolated[3], interpolated[4]);
+				Normalize(interpolated[5], interpolated[6], interpolated[7]);
+				if (attributeCount == ATTRIBUTE_COUNT)
+				{
+					Normalize(interpolated[8], interpolated[9], interpolated[10]);
+				}
+
+				Store(laneDepth, interpolatedZDepth);
+				for (int attribute{ 0 }; attribute < attributeCount; ++attribute)
+				{
+					Store(laneValues[attribute], interpolated[attribute]);
+				}
+
+				//du/dx = (d(u/w)/dx - u * d(1/w)/dx) * w, same for v & y
+				for (int axis{ 0 }; axis < 2; ++axis)
+				{
+					Store(laneUVDerivatives[axis * 2], Mul(Sub(uOverWStep[axis], Mul(interpolated[0], invWStep[axis])), interpolatedWDepth));
+					Store(laneUVDerivatives[axis * 2 + 1], Mul(Sub(vOverWStep[axis], Mul(interpolated[1], invWStep[axis])), interpolatedWDepth));
+				}
+
+				for (int lane{ 0 }; lane < WIDTH; ++lane)
+				{
+					if ((laneMask & (1 << lane)) == 0)
+					{
+						continue;
+					}
+
+					Vertex_Out pixel{};
+					pixel.uv = { laneValues[0][lane], laneValues[1][lane] };
+					pixel.uvDerivativeX = { laneUVDerivatives[0][lane], laneUVDerivatives[1][lane] };
+					pixel.uvDerivativeY = { laneUVDerivatives[2][lane], laneUVDerivatives[3][lane] };
+					pixel.normal = { laneValues[2][lane], laneValues[3][lane], laneValues[4][lane] };
+					pixel.tangent = { laneValues[5][lane], laneValues[6][lane], laneValues[7][lane] };
+					pixel.viewDirection = { laneValues[8][lane], laneValues[9][lane], laneValues[10][lane] };
+					pixel.worldPosition = { laneValues[11][lane], laneValues[12][lane], laneValues[13][lane] };
+
+					if (m_ShowDepthBuffer)
+					{
+						const float depthColor{ Remap(laneDepth[lane], 0.985f, 1.0f) };
+						pixel.color = { depthColor, depthColor, depthColor };
+					}
+
+					OutputPixel((px + lane) + py * m_Width, pixel);
+				}
+			}
+		}
+	}
+}
+#endif
@@ -0,0 +1,11 @@
+#include "pch.h"
+#include "RendererSimd.h"
+
+#if defined(SIMD_ENABLED)
+namespace dae
+{
+	//4 lane versions for CPUs without AVX2, any x64 CPU has SSE2
+	template void Renderer::TransformVerticesSimd<4>(const VertexStream& in, const Matrix& worldMatrix, const Matrix& worldViewProjectionMatrix, size_t begin, size_t end, VertexStream_Out& out) const;
+	template void Renderer::RasterizeTriangleSimd<4>(const TriangleSetup& setup, const TileRect& tile, TileDepthBuffer& tileDepth) const;
+}
+#endif
@@ -0,0 +1,50 @@
+#include "pch.h"
+#include "Simd.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace dae
+{
+	namespace Simd
+	{
+		bool IsAvx2Supported()
+		{
+#if defined(SIMD_DISABLED)
+			return false;
+#elif defined(_MSC_VER)
+			//Leaf 1 ECX: bit 12 FMA, bit 27 OSXSAVE, bit 28 AVX
+			int registers[4]{};
+			__cpuid(registers, 1);
+			const bool hasFma{ (registers[2] & (1 << 12)) != 0 };
+			const bool hasOsXSave{ (registers[2] & (1 << 27)) != 0 };
+			const bool hasAvx{ (registers[2] & (1 << 28)) != 0 };
+			if (!hasFma || !hasOsXSave || !hasAvx)
+			{
+				return false;
+			}
+
+			//The OS has to save the SSE & AVX registers on a context switch, XCR0 bits 1 & 2
+			if ((_xgetbv(0) & 0x6) != 0x6)
+			{
+				return false;
+			}
+
+			//Leaf 7 EBX: bit 5 AVX2
+			__cpuid(registers, 0);
+			if (registers[0] < 7)
+			{
+				return false;
+			}
+			__cpuidex(registers, 7, 0);
+			return (registers[1] & (1 << 5)) != 0;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+			//Checks the OS support for the AVX registers as well
+			return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+			return false;
+#endif
+		}
+	}
+}
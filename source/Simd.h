@@ -0,0 +1,112 @@
+#pragma once
+
+//Thin wrappers over the SSE/AVX2 float registers used by the software rasterizer
+//Every x64 build has 4 SSE2 lanes, the 8 lane AVX2 versions are only compiled into RendererAvx2.cpp,
+//which is the one file built with /arch:AVX2 (-mavx2 -mfma). The renderer picks it at startup when the CPU supports it
+//A translation unit selects the AVX2 width by defining SIMD_AVX2 before including this header
+//Each width lives in its own inline namespace, so the 4 & 8 lane helpers never share a symbol between files
+//Define SIMD_DISABLED to force the scalar paths
+#if !defined(SIMD_DISABLED)
+	#if defined(SIMD_AVX2)
+		#if !defined(__AVX2__)
+			#error SIMD_AVX2 needs a translation unit built with /arch:AVX2 or -mavx2 -mfma
+		#endif
+		#include <immintrin.h>
+		#define SIMD_ENABLED
+	#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+		#include <emmintrin.h>
+		#define SIMD_SSE
+		#define SIMD_ENABLED
+	#endif
+#endif
+
+namespace dae
+{
+	namespace Simd
+	{
+		//Widest register the rasterizer can use on this CPU, checked once through CPUID
+		//Defined in Simd.cpp, which is built for the baseline architecture so the check itself runs everywhere
+		bool IsAvx2Supported();
+	}
+}
+
+#if defined(SIMD_ENABLED)
+namespace dae
+{
+	namespace Simd
+	{
+#if defined(SIMD_AVX2)
+		inline namespace Avx2
+#else
+		inline namespace Sse
+#endif
+		{
+#if defined(SIMD_AVX2)
+			constexpr int WIDTH{ 8 };
+			using Float = __m256;
+
+			inline Float Set(float value) { return _mm256_set1_ps(value); }
+			inline Float LaneOffsets() { return _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f); }
+			inline Float Load(const float* pValues) { return _mm256_loadu_ps(pValues); }
+			inline void Store(float* pValues, Float value) { _mm256_storeu_ps(pValues, value); }
+
+			inline Float Add(Float a, Float b) { return _mm256_add_ps(a, b); }
+			inline Float Sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+			inline Float Mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+			inline Float Div(Float a, Float b) { return _mm256_div_ps(a, b); }
+#if defined(__FMA__) || defined(_MSC_VER)
+			//MSVC has no separate FMA switch, /arch:AVX2 enables it as well & IsAvx2Supported checks for both
+			inline Float MulAdd(Float a, Float b, Float c) { return _mm256_fmadd_ps(a, b, c); }
+#else
+			inline Float MulAdd(Float a, Float b, Float c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+#endif
+			inline Float Min(Float a, Float b) { return _mm256_min_ps(a, b); }
+			inline Float Max(Float a, Float b) { return _mm256_max_ps(a, b); }
+			inline Float Sqrt(Float a) { return _mm256_sqrt_ps(a); }
+
+			//Comparisons return a mask with all bits set in the lanes where they hold
+			inline Float GreaterEqual(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+			inline Float LessEqual(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+			inline Float Less(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+			inline Float And(Float a, Float b) { return _mm256_and_ps(a, b); }
+			inline Float Select(Float mask, Float a, Float b) { return _mm256_blendv_ps(b, a, mask); }
+			inline int MoveMask(Float mask) { return _mm256_movemask_ps(mask); }
+#else
+			constexpr int WIDTH{ 4 };
+			using Float = __m128;
+
+			inline Float Set(float value) { return _mm_set1_ps(value); }
+			inline Float LaneOffsets() { return _mm_setr_ps(0.f, 1.f, 2.f, 3.f); }
+			inline Float Load(const float* pValues) { return _mm_loadu_ps(pValues); }
+			inline void Store(float* pValues, Float value) { _mm_storeu_ps(pValues, value); }
+
+			inline Float Add(Float a, Float b) { return _mm_add_ps(a, b); }
+			inline Float Sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+			inline Float Mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+			inline Float Div(Float a, Float b) { return _mm_div_ps(a, b); }
+			inline Float MulAdd(Float a, Float b, Float c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+			inline Float Min(Float a, Float b) { return _mm_min_ps(a, b); }
+			inline Float Max(Float a, Float b) { return _mm_max_ps(a, b); }
+			inline Float Sqrt(Float a) { return _mm_sqrt_ps(a); }
+
+			//Comparisons return a mask with all bits set in the lanes where they hold
+			inline Float GreaterEqual(Float a, Float b) { return _mm_cmpge_ps(a, b); }
+			inline Float LessEqual(Float a, Float b) { return _mm_cmple_ps(a, b); }
+			inline Float Less(Float a, Float b) { return _mm_cmplt_ps(a, b); }
+			inline Float And(Float a, Float b) { return _mm_and_ps(a, b); }
+			inline Float Select(Float mask, Float a, Float b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+			inline int MoveMask(Float mask) { return _mm_movemask_ps(mask); }
+#endif
+
+			//Normalizes the 3D vectors stored in x, y & z for every lane
+			inline void Normalize(Float& x, Float& y, Float& z)
+			{
+				const Float invLength{ Div(Set(1.f), Sqrt(MulAdd(x, x, MulAdd(y, y, Mul(z, z))))) };
+				x = Mul(x, invLength);
+				y = Mul(y, invLength);
+				z = Mul(z, invLength);
+			}
+		}
+	}
+}
+#endif
@@ -2,16 +2,38 @@
 #include "Textures.h"
 #include "Vector2.h"
 
+#include <cstring>
+
+#if !defined(SOFTWARE_ONLY)
 DirectX_Texture::DirectX_Texture(const std::string& path, ID3D11Device* pDevice)
 {
 	// Make SDL_Surface, release at the end
 	SDL_Surface* pSurface = IMG_Load(path.c_str());
+	if (!pSurface)
+	{
+		std::cout << "Failed to load texture: " << path << '\n';
+		return;
+	}
+
+	Create(pSurface->pixels, pSurface->w, pSurface->h, pSurface->pitch, pDevice);
+
+	// SDL_Surface no longer needed
+	SDL_FreeSurface(pSurface);
+}
+
+DirectX_Texture::DirectX_Texture(const dae::ColorRGB& color, float alpha, ID3D11Device* pDevice)
+{
+	const uint8_t pixel[4]{ static_cast<uint8_t>(color.r * 255.f + 0.5f), static_cast<uint8_t>(color.g * 255.f + 0.5f), static_cast<uint8_t>(color.b * 255.f + 0.5f), static_cast<uint8_t>(alpha * 255.f + 0.5f) };
+	Create(pixel, 1, 1, sizeof(pixel), pDevice);
+}
 
+void DirectX_Texture::Create(const void* pPixels, int width, int height, int pitch, ID3D11Device* pDevice)
+{
 	// Texture description
 	const DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM;
 	D3D11_TEXTURE2D_DESC desc{};
-	desc.Width	= pSurface->w;
-	desc.Height = pSurface->h;
+	desc.Width	= width;
+	desc.Height = height;
 	desc.MipLevels = 1;
 	desc.ArraySize = 1;
 	desc.Format = format;
@@ -22,13 +44,15 @@ DirectX_Texture::DirectX_Texture(const std::string& path, ID3D11Device* pDevice)
 	desc.CPUAccessFlags = 0;
 	desc.MiscFlags = 0;
 
-	// InitData SDL_Surface
+	// InitData pixels
 	D3D11_SUBRESOURCE_DATA initData{};
-	initData.pSysMem = pSurface->pixels;
-	initData.SysMemPitch = static_cast<UINT>(pSurface->pitch);
-	initData.SysMemSlicePitch = static_cast<UINT>(pSurface->h * pSurface->pitch);
+	initData.pSysMem = pPixels;
+	initData.SysMemPitch = static_cast<UINT>(pitch);
+	initData.SysMemSlicePitch = static_cast<UINT>(height * pitch);
 
 	HRESULT hr = pDevice->CreateTexture2D(&desc, &initData, &m_pResource);
+	if (FAILED(hr))
+		return;
 
 	// ShaderResourceView description
 	D3D11_SHADER_RESOURCE_VIEW_DESC SRVDesc{};
@@ -37,9 +61,6 @@ DirectX_Texture::DirectX_Texture(const std::string& path, ID3D11Device* pDevice)
 	SRVDesc.Texture2D.MipLevels = 1;
 
 	hr = pDevice->CreateShaderResourceView(m_pResource, &SRVDesc, &m_pShaderResourceView);
-
-	// SDL_Surface no longer needed
-	SDL_FreeSurface(pSurface);
 }
 
 DirectX_Texture::~DirectX_Texture()
@@ -62,46 +83,292 @@ ID3D11ShaderResourceView* DirectX_Texture::GetShaderResourceView() const
 {
 	return m_pShaderResourceView;
 }
+#endif
 
 namespace dae
 {
-	Software_Texture::Software_Texture(SDL_Surface* pSurface) :
-		m_pSurface{ pSurface },
-		m_pSurfacePixels{ (uint32_t*)pSurface->pixels }
+	static int WrapCoordinate(int coordinate, int size)
 	{
+		coordinate %= size;
+		return coordinate < 0 ? coordinate + size : coordinate;
 	}
 
-	Software_Texture::~Software_Texture()
+	static TextureSample Lerp(const TextureSample& a, const TextureSample& b, float factor, int channelCount)
 	{
-		if (m_pSurface)
+		TextureSample sample{};
+		for (int channel{ 0 }; channel < channelCount; ++channel)
 		{
-			SDL_FreeSurface(m_pSurface);
-			m_pSurface = nullptr;
+			sample.channels[channel] = Lerpf(a.channels[channel], b.channels[channel], factor);
 		}
+		return sample;
 	}
 
-	Software_Texture* Software_Texture::LoadFromFile(const std::string& path)
+	Software_Texture::Software_Texture(MipLevel&& baseLevel, int channelCount, TextureLayout layout)
+		: m_ChannelCount{ channelCount }
 	{
-		return new Software_Texture{ IMG_Load(path.c_str()) };
+		m_MipLevels.push_back(std::move(baseLevel));
+
+		//Levels are built linear & reordered afterwards
+		GenerateMipLevels();
+
+		m_Layout = layout;
+		ApplyLayout();
 	}
 
-	ColorRGB Software_Texture::Sample(const Vector2& uv) const
+	bool Software_Texture::DecodeSurface(const std::string& path, MipLevel& level, const std::array<int, 4>& targetChannels)
 	{
-		Uint8 r{};
-		Uint8 g{};
-		Uint8 b{};
+		SDL_Surface* pSurface{ IMG_Load(path.c_str()) };
+		if (!pSurface)
+		{
+			std::cout << "Failed to load texture: " << path << '\n';
+			return false;
+		}
 
-		const int x{ static_cast<int>(uv.x * m_pSurface->w) };
-		const int y{ static_cast<int>(uv.y * m_pSurface->h) };
+		if (level.texels.empty())
+		{
+			level.width = pSurface->w;
+			level.height = pSurface->h;
+			level.Allocate(level.width * level.height);
+		}
+		else if (pSurface->w != level.width || pSurface->h != level.height)
+		{
+			std::cout << "Texture size doesn't match the rest of the material: " << path << '\n';
+			SDL_FreeSurface(pSurface);
+			return false;
+		}
 
-		// Calculate the current pixelIndex on the texture
-		const Uint32 pixelIndex{ m_pSurfacePixels[x + y * m_pSurface->w] };
+		//Decode every texel once, sampling never has to look at the surface format again
+		const int bytesPerPixel{ pSurface->format->BytesPerPixel };
+		for (int y{ 0 }; y < level.height; ++y)
+		{
+			const uint8_t* pRow{ static_cast<const uint8_t*>(pSurface->pixels) + y * pSurface->pitch };
+			for (int x{ 0 }; x < level.width; ++x)
+			{
+				uint32_t pixel{};
+				std::memcpy(&pixel, pRow + x * bytesPerPixel, bytesPerPixel);
+
+				uint8_t rgba[4]{};
+				SDL_GetRGBA(pixel, pSurface->format, &rgba[0], &rgba[1], &rgba[2], &rgba[3]);
+
+				const int index{ x + y * level.width };
+				uint64_t texel{ level.Load(index) };
+				for (int channel{ 0 }; channel < 4; ++channel)
+				{
+					if (targetChannels[channel] != UNUSED_CHANNEL)
+					{
+						texel |= static_cast<uint64_t>(rgba[channel]) << (targetChannels[channel] * 8);
+					}
+				}
+				level.Store(index, texel);
+			}
+		}
+
+		SDL_FreeSurface(pSurface);
+		return true;
+	}
+
+	Software_Texture* Software_Texture::LoadFromFile(const std::string& path, TextureLayout layout)
+	{
+		MipLevel baseLevel{};
+		baseLevel.texelSize = IMAGE_TEXEL_SIZE;
+		if (!DecodeSurface(path, baseLevel, { 0, 1, 2, 3 }))
+			return nullptr;
+
+		return new Software_Texture{ std::move(baseLevel), IMAGE_CHANNEL_COUNT, layout };
+	}
+
+	Software_Texture* Software_Texture::LoadMaterial(const std::string& diffusePath, const std::string& normalPath, const std::string& specularPath, const std::string& glossinessPath, TextureLayout layout)
+	{
+		MipLevel baseLevel{};
+		if (!DecodeSurface(diffusePath, baseLevel, { MATERIAL_DIFFUSE, MATERIAL_DIFFUSE + 1, MATERIAL_DIFFUSE + 2, UNUSED_CHANNEL }) ||
+			!DecodeSurface(normalPath, baseLevel, { MATERIAL_NORMAL, MATERIAL_NORMAL + 1, MATERIAL_NORMAL + 2, UNUSED_CHANNEL }) ||
+			!DecodeSurface(specularPath, baseLevel, { MATERIAL_SPECULAR, UNUSED_CHANNEL, UNUSED_CHANNEL, UNUSED_CHANNEL }) ||
+			!DecodeSurface(glossinessPath, baseLevel, { MATERIAL_GLOSSINESS, UNUSED_CHANNEL, UNUSED_CHANNEL, UNUSED_CHANNEL }))
+		{
+			return nullptr;
+		}
 
-		// Get the r g b values from the current pixel on the texture
-		SDL_GetRGB(pixelIndex, m_pSurface->format, &r, &g, &b);
+		return new Software_Texture{ std::move(baseLevel), TextureSample::CHANNEL_COUNT, layout };
+	}
+
+	Software_Texture* Software_Texture::CreatePlaceholderMaterial(const ColorRGB& diffuse)
+	{
+		const auto toByte{ [](float value) { return static_cast<uint64_t>(std::clamp(value, 0.f, 1.f) * 255.f + 0.5f); } };
 
-		const float maxColorValue{ 255.0f };
+		//Tangent space normal straight up, no specular & no glossiness so those channels are never unpacked
+		MipLevel baseLevel{ 1, 1 };
+		baseLevel.Allocate(1);
+		baseLevel.Store(0,
+			toByte(diffuse.r) << (MATERIAL_DIFFUSE * 8) | toByte(diffuse.g) << ((MATERIAL_DIFFUSE + 1) * 8) | toByte(diffuse.b) << ((MATERIAL_DIFFUSE + 2) * 8) |
+			toByte(0.5f) << (MATERIAL_NORMAL * 8) | toByte(0.5f) << ((MATERIAL_NORMAL + 1) * 8) | toByte(1.f) << ((MATERIAL_NORMAL + 2) * 8));
+
+		return new Software_Texture{ std::move(baseLevel), MATERIAL_SPECULAR, TextureLayout::Linear };
+	}
+
+	void Software_Texture::GenerateMipLevels()
+	{
+		//Box filter, odd sizes reuse the last row/column
+		while (m_MipLevels.back().width > 1 || m_MipLevels.back().height > 1)
+		{
+			const MipLevel& previous{ m_MipLevels.back() };
 
-		return ColorRGB{ r / maxColorValue, g / maxColorValue, b / maxColorValue };
+			MipLevel level{ std::max(previous.width / 2, 1), std::max(previous.height / 2, 1), 0, previous.texelSize };
+			level.Allocate(level.width * level.height);
+
+			for (int y{ 0 }; y < level.height; ++y)
+			{
+				for (int x{ 0 }; x < level.width; ++x)
+				{
+					const int x0{ std::min(x * 2, previous.width - 1) };
+					const int x1{ std::min(x * 2 + 1, previous.width - 1) };
+					const int y0{ std::min(y * 2, previous.height - 1) };
+					const int y1{ std::min(y * 2 + 1, previous.height - 1) };
+
+					//Per channel, with rounding
+					const uint64_t texels[4]{ previous.Load(x0 + y0 * previous.width), previous.Load(x1 + y0 * previous.width), previous.Load(x0 + y1 * previous.width), previous.Load(x1 + y1 * previous.width) };
+
+					//One byte per channel
+					uint64_t averagedTexel{};
+					for (int channel{ 0 }; channel < level.texelSize; ++channel)
+					{
+						const int shift{ channel * 8 };
+						uint64_t sum{ 2 };
+						for (const uint64_t texel : texels)
+						{
+							sum += (texel >> shift) & 0xFF;
+						}
+						averagedTexel |= (sum / 4) << shift;
+					}
+
+					level.Store(x + y * level.width, averagedTexel);
+				}
+			}
+
+			m_MipLevels.push_back(std::move(level));
+		}
+	}
+
+	void Software_Texture::ApplyLayout()
+	{
+		if (m_Layout == TextureLayout::Linear)
+			return;
+
+		//Partial blocks at the right & bottom edge are padded, the padding is never sampled
+		for (MipLevel& level : m_MipLevels)
+		{
+			level.blocksPerRow = (level.width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+			const int blocksPerColumn{ (level.height + BLOCK_SIZE - 1) / BLOCK_SIZE };
+
+			MipLevel tiledLevel{ level.width, level.height, level.blocksPerRow, level.texelSize };
+			tiledLevel.Allocate(level.blocksPerRow * blocksPerColumn * BLOCK_SIZE * BLOCK_SIZE);
+			for (int y{ 0 }; y < level.height; ++y)
+			{
+				for (int x{ 0 }; x < level.width; ++x)
+				{
+					tiledLevel.Store(GetTexelIndex(level, x, y), level.Load(x + y * level.width));
+				}
+			}
+			level = std::move(tiledLevel);
+		}
+	}
+
+	TextureSample Software_Texture::SamplePoint(int level, const Vector2& uv) const
+	{
+		const MipLevel& mipLevel{ m_MipLevels[level] };
+
+		const int x{ WrapCoordinate(static_cast<int>(std::floor(uv.x * mipLevel.width)), mipLevel.width) };
+		const int y{ WrapCoordinate(static_cast<int>(std::floor(uv.y * mipLevel.height)), mipLevel.height) };
+
+		return GetTexel(mipLevel, x, y);
+	}
+
+	TextureSample Software_Texture::SampleBilinear(int level, const Vector2& uv) const
+	{
+		const MipLevel& mipLevel{ m_MipLevels[level] };
+
+		//Texel centers sit at half coordinates
+		const float texelX{ uv.x * mipLevel.width - 0.5f };
+		const float texelY{ uv.y * mipLevel.height - 0.5f };
+		const float floorX{ std::floor(texelX) };
+		const float floorY{ std::floor(texelY) };
+		const float fractionX{ texelX - floorX };
+		const float fractionY{ texelY - floorY };
+
+		const int x0{ WrapCoordinate(static_cast<int>(floorX), mipLevel.width) };
+		const int y0{ WrapCoordinate(static_cast<int>(floorY), mipLevel.height) };
+		const int x1{ x0 + 1 < mipLevel.width ? x0 + 1 : 0 };
+		const int y1{ y0 + 1 < mipLevel.height ? y0 + 1 : 0 };
+
+		const TextureSample top{ Lerp(GetTexel(mipLevel, x0, y0), GetTexel(mipLevel, x1, y0), fractionX, m_ChannelCount) };
+		const TextureSample bottom{ Lerp(GetTexel(mipLevel, x0, y1), GetTexel(mipLevel, x1, y1), fractionX, m_ChannelCount) };
+		return Lerp(top, bottom, fractionY, m_ChannelCount);
+	}
+
+	TextureSample Software_Texture::SampleTrilinear(float lod, const Vector2& uv) const
+	{
+		const int lastLevel{ static_cast<int>(m_MipLevels.size()) - 1 };
+		if (lod <= 0.f)
+			return SampleBilinear(0, uv);
+		if (lod >= lastLevel)
+			return SampleBilinear(lastLevel, uv);
+
+		const int level{ static_cast<int>(lod) };
+		return Lerp(SampleBilinear(level, uv), SampleBilinear(level + 1, uv), lod - level, m_ChannelCount);
+	}
+
+	TextureSample Software_Texture::Sample(const Vector2& uv, const Vector2& uvDerivativeX, const Vector2& uvDerivativeY, FilteringMethod filteringMethod) const
+	{
+		//Footprint of the pixel in texels along both screen axes
+		const float width{ static_cast<float>(m_MipLevels[0].width) };
+		const float height{ static_cast<float>(m_MipLevels[0].height) };
+		const Vector2 texelDerivativeX{ uvDerivativeX.x * width, uvDerivativeX.y * height };
+		const Vector2 texelDerivativeY{ uvDerivativeY.x * width, uvDerivativeY.y * height };
+		const float lengthSquaredX{ texelDerivativeX.SqrMagnitude() };
+		const float lengthSquaredY{ texelDerivativeY.SqrMagnitude() };
+
+		const int lastLevel{ static_cast<int>(m_MipLevels.size()) - 1 };
+
+		switch (filteringMethod)
+		{
+		case FilteringMethod::POINT:
+		case FilteringMethod::BILINEAR:
+		{
+			//Nearest level, log2 of the longest footprint axis
+			const float lod{ 0.5f * std::log2(std::max(std::max(lengthSquaredX, lengthSquaredY), FLT_MIN)) };
+			const int level{ std::clamp(static_cast<int>(lod + 0.5f), 0, lastLevel) };
+
+			return filteringMethod == FilteringMethod::POINT ? SamplePoint(level, uv) : SampleBilinear(level, uv);
+		}
+		case FilteringMethod::TRILINEAR:
+		{
+			const float lod{ 0.5f * std::log2(std::max(std::max(lengthSquaredX, lengthSquaredY), FLT_MIN)) };
+			return SampleTrilinear(lod, uv);
+		}
+		case FilteringMethod::ANISOTROPIC:
+		{
+			//Several trilinear taps spread along the long axis, the level only has to cover the short one
+			const bool isMajorX{ lengthSquaredX >= lengthSquaredY };
+			const float majorLength{ std::sqrt(isMajorX ? lengthSquaredX : lengthSquaredY) };
+			const float minorLength{ std::sqrt(isMajorX ? lengthSquaredY : lengthSquaredX) };
+
+			const int tapCount{ std::clamp(static_cast<int>(std::ceil(majorLength / std::max(minorLength, FLT_MIN))), 1, MAX_ANISOTROPY) };
+			const float lod{ std::log2(std::max(majorLength / tapCount, FLT_MIN)) };
+			const Vector2& majorAxis{ isMajorX ? uvDerivativeX : uvDerivativeY };
+
+			TextureSample sample{};
+			for (int tap{ 0 }; tap < tapCount; ++tap)
+			{
+				const float offset{ (tap + 0.5f) / tapCount - 0.5f };
+				const TextureSample tapSample{ SampleTrilinear(lod, uv + majorAxis * offset) };
+				for (int channel{ 0 }; channel < m_ChannelCount; ++channel)
+				{
+					sample.channels[channel] += tapSample.channels[channel] / tapCount;
+				}
+			}
+			return sample;
+		}
+		default:
+			return SamplePoint(0, uv);
+		}
 	}
 }
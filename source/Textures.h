@@ -1,8 +1,17 @@
 #pragma once
+#include "DataTypes.h"
+
+#include <array>
+#include <cstring>
+#include <new>
+
+#if !defined(SOFTWARE_ONLY)
 class DirectX_Texture final
 {
 public:
 	DirectX_Texture(const std::string& path, ID3D11Device* pDevice);
+	//Single texel of one color, bound until the real texture is loaded
+	DirectX_Texture(const dae::ColorRGB& color, float alpha, ID3D11Device* pDevice);
 	~DirectX_Texture();
 
 	ID3D11Texture2D* GetResource() const;
@@ -12,25 +21,188 @@ private:
 	ID3D11Texture2D* m_pResource{};
 	ID3D11ShaderResourceView* m_pShaderResourceView{};
 
+	//Rows of rgba bytes
+	void Create(const void* pPixels, int width, int height, int pitch, ID3D11Device* pDevice);
+
 };
+#endif
 
 namespace dae
 {
 	struct Vector2;
 
+	//How the texels of every mip level are ordered in memory
+	enum class TextureLayout
+	{
+		Linear,	//Row by row
+		Tiled	//4x4 blocks stored row by row, so steps along v mostly stay in the cache lines steps along u loaded
+	};
+
+	//Filtered channels of one sample in [0, 1], an image texture fills 0 - 3 with its rgba & leaves the rest 0
+	struct TextureSample
+	{
+		static constexpr int CHANNEL_COUNT{ 8 };
+		float channels[CHANNEL_COUNT]{};
+
+		ColorRGB GetColor(int firstChannel = 0) const
+		{
+			return { channels[firstChannel], channels[firstChannel + 1], channels[firstChannel + 2] };
+		}
+	};
+
 	class Software_Texture final
 	{
 	public:
-		~Software_Texture();
+		~Software_Texture() = default;
+
+		static Software_Texture* LoadFromFile(const std::string& path, TextureLayout layout = TextureLayout::Linear);
+
+		//Interleaves the maps of a material into one texel per uv, so shading a pixel is a single fetch
+		//All maps need the same size, the specular & glossiness maps are read from their red channel
+		static Software_Texture* LoadMaterial(const std::string& diffusePath, const std::string& normalPath, const std::string& specularPath, const std::string& glossinessPath,
+			TextureLayout layout = TextureLayout::Linear);
+
+		//Single material texel with a flat normal & no specular, drawn with until the real material is loaded
+		static Software_Texture* CreatePlaceholderMaterial(const ColorRGB& diffuse);
 
-		static Software_Texture* LoadFromFile(const std::string& path);
-		ColorRGB Sample(const Vector2& uv) const;
+		//Channels of a material texel: diffuse rgb, tangent space normal xyz, specular, glossiness
+		static constexpr int MATERIAL_DIFFUSE{ 0 };
+		static constexpr int MATERIAL_NORMAL{ 3 };
+		static constexpr int MATERIAL_SPECULAR{ 6 };
+		static constexpr int MATERIAL_GLOSSINESS{ 7 };
+
+		//Wrapping sampler, the mip level(s) follow from the screen space uv derivatives of the pixel
+		TextureSample Sample(const Vector2& uv, const Vector2& uvDerivativeX, const Vector2& uvDerivativeY, FilteringMethod filteringMethod) const;
 
 	private:
-		Software_Texture(SDL_Surface* pSurface);
+		//Texel storage starts on a cache line, so a tiled 4x4 block of image texels is exactly one line & one of material texels two
+		static constexpr size_t CACHE_LINE_SIZE{ 64 };
+
+		template<typename T>
+		struct CacheLineAllocator
+		{
+			using value_type = T;
+
+			CacheLineAllocator() = default;
+			template<typename U>
+			CacheLineAllocator(const CacheLineAllocator<U>&) {}
+
+			T* allocate(size_t count)
+			{
+				return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t{ CACHE_LINE_SIZE }));
+			}
+			void deallocate(T* pData, size_t)
+			{
+				::operator delete(pData, std::align_val_t{ CACHE_LINE_SIZE });
+			}
 
-		SDL_Surface* m_pSurface{ nullptr };
-		uint32_t* m_pSurfacePixels{ nullptr };
+			template<typename U>
+			bool operator==(const CacheLineAllocator<U>&) const { return true; }
+		};
+		using TexelBytes = std::vector<uint8_t, CacheLineAllocator<uint8_t>>;
+
+		//Image textures keep their rgba in 4 bytes, only materials need the 8 packed channels
+		static constexpr int IMAGE_TEXEL_SIZE{ sizeof(uint32_t) };
+		static constexpr int MATERIAL_TEXEL_SIZE{ sizeof(uint64_t) };
+
+		//Level 0 is the full resolution image, every next level halves it down to 1x1
+		//Texels are converted once at load time to one byte per channel, channel 0 in the lowest byte, whatever the surface format was
+		struct MipLevel
+		{
+			int width{};
+			int height{};
+			int blocksPerRow{};
+			int texelSize{ MATERIAL_TEXEL_SIZE };
+			TexelBytes texels{};
+
+			//Zeroed, so channels nothing writes to stay 0
+			void Allocate(int texelCount)
+			{
+				texels.assign(static_cast<size_t>(texelCount) * texelSize, 0);
+			}
+			uint64_t Load(int index) const
+			{
+				const uint8_t* pTexel{ texels.data() + static_cast<size_t>(index) * texelSize };
+				if (texelSize == IMAGE_TEXEL_SIZE)
+				{
+					uint32_t texel{};
+					std::memcpy(&texel, pTexel, sizeof(texel));
+					return texel;
+				}
+
+				uint64_t texel{};
+				std::memcpy(&texel, pTexel, sizeof(texel));
+				return texel;
+			}
+			void Store(int index, uint64_t texel)
+			{
+				uint8_t* pTexel{ texels.data() + static_cast<size_t>(index) * texelSize };
+				if (texelSize == IMAGE_TEXEL_SIZE)
+				{
+					const uint32_t imageTexel{ static_cast<uint32_t>(texel) };
+					std::memcpy(pTexel, &imageTexel, sizeof(imageTexel));
+					return;
+				}
+
+				std::memcpy(pTexel, &texel, sizeof(texel));
+			}
+		};
+
+		Software_Texture(MipLevel&& baseLevel, int channelCount, TextureLayout layout);
+
+		//Channels an image texture fills, the packed material channels past them are only unpacked for materials
+		static constexpr int IMAGE_CHANNEL_COUNT{ 4 };
+
+		static constexpr int BLOCK_SIZE{ 4 };
+
+		//Most taps along the major axis of an anisotropic footprint
+		static constexpr int MAX_ANISOTROPY{ 8 };
+
+		//Channel byte to [0, 1], a table load instead of a conversion & divide per channel
+		static constexpr std::array<float, 256> BYTE_TO_FLOAT{ []
+			{
+				std::array<float, 256> table{};
+				for (int value{ 0 }; value < 256; ++value)
+				{
+					table[value] = value / 255.f;
+				}
+				return table;
+			}() };
+
+		//Writes the rgba of every surface pixel to the given texel channels, the first surface sets the level size & later ones must match it
+		static constexpr int UNUSED_CHANNEL{ -1 };
+		static bool DecodeSurface(const std::string& path, MipLevel& level, const std::array<int, 4>& targetChannels);
+
+		TextureSample UnpackTexel(uint64_t texel) const
+		{
+			TextureSample sample{};
+			for (int channel{ 0 }; channel < m_ChannelCount; ++channel)
+			{
+				sample.channels[channel] = BYTE_TO_FLOAT[(texel >> (channel * 8)) & 0xFF];
+			}
+			return sample;
+		}
+
+		void GenerateMipLevels();
+		void ApplyLayout();
+
+		int GetTexelIndex(const MipLevel& level, int x, int y) const
+		{
+			if (m_Layout == TextureLayout::Linear)
+				return x + y * level.width;
+
+			return (((y >> 2) * level.blocksPerRow + (x >> 2)) << 4) | ((y & 3) << 2) | (x & 3);
+		}
+		TextureSample GetTexel(const MipLevel& level, int x, int y) const
+		{
+			return UnpackTexel(level.Load(GetTexelIndex(level, x, y)));
+		}
+		TextureSample SamplePoint(int level, const Vector2& uv) const;
+		TextureSample SampleBilinear(int level, const Vector2& uv) const;
+		TextureSample SampleTrilinear(float lod, const Vector2& uv) const;
+
+		TextureLayout m_Layout{ TextureLayout::Linear };
+		int m_ChannelCount{ TextureSample::CHANNEL_COUNT };
+		std::vector<MipLevel> m_MipLevels{};
 	};
 }
-
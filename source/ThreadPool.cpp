@@ -0,0 +1,96 @@
+#include "pch.h"
+#include "ThreadPool.h"
+
+namespace dae
+{
+	ThreadPool::ThreadPool(uint32_t threadCount)
+	{
+		const uint32_t workerCount{ std::max(threadCount, 1u) - 1 };
+
+		m_Workers.reserve(workerCount);
+		for (uint32_t index{ 0 }; index < workerCount; ++index)
+		{
+			m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ m_Mutex };
+			m_IsStopping = true;
+		}
+		m_WakeCondition.notify_all();
+
+		for (std::thread& worker : m_Workers)
+		{
+			worker.join();
+		}
+	}
+
+	void ThreadPool::ParallelFor(int count, const std::function<void(int)>& job)
+	{
+		if (count <= 0)
+			return;
+
+		//Nothing to share
+		if (m_Workers.empty() || count == 1)
+		{
+			for (int index{ 0 }; index < count; ++index)
+			{
+				job(index);
+			}
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock{ m_Mutex };
+			m_pJob = &job;
+			m_JobCount = count;
+			m_NextJobIndex = 0;
+			m_BusyWorkers = static_cast<uint32_t>(m_Workers.size());
+			++m_Generation;
+		}
+		m_WakeCondition.notify_all();
+
+		RunJobs();
+
+		std::unique_lock<std::mutex> lock{ m_Mutex };
+		m_DoneCondition.wait(lock, [this]() { return m_BusyWorkers == 0; });
+		m_pJob = nullptr;
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		uint64_t generation{};
+
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock{ m_Mutex };
+				m_WakeCondition.wait(lock, [this, generation]() { return m_IsStopping || m_Generation != generation; });
+
+				if (m_IsStopping)
+					return;
+
+				generation = m_Generation;
+			}
+
+			RunJobs();
+
+			std::lock_guard<std::mutex> lock{ m_Mutex };
+			if (--m_BusyWorkers == 0)
+			{
+				m_DoneCondition.notify_one();
+			}
+		}
+	}
+
+	void ThreadPool::RunJobs()
+	{
+		for (int index{ m_NextJobIndex++ }; index < m_JobCount; index = m_NextJobIndex++)
+		{
+			(*m_pJob)(index);
+		}
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dae
+{
+	class ThreadPool final
+	{
+	public:
+		//threadCount includes the calling thread, so (threadCount - 1) workers get spawned
+		explicit ThreadPool(uint32_t threadCount = std::thread::hardware_concurrency());
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) noexcept = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool& operator=(ThreadPool&&) noexcept = delete;
+
+		//Runs job(index) for every index in [0, count) and returns once all of them are done
+		//The calling thread helps out, jobs are handed out one index at a time
+		void ParallelFor(int count, const std::function<void(int)>& job);
+
+		uint32_t GetThreadCount() const
+		{
+			return static_cast<uint32_t>(m_Workers.size()) + 1;
+		}
+
+	private:
+		void WorkerLoop();
+		void RunJobs();
+
+		std::vector<std::thread> m_Workers{};
+
+		std::mutex m_Mutex{};
+		std::condition_variable m_WakeCondition{};
+		std::condition_variable m_DoneCondition{};
+
+		const std::function<void(int)>* m_pJob{ nullptr };
+		int m_JobCount{};
+		std::atomic<int> m_NextJobIndex{};
+
+		uint64_t m_Generation{};
+		uint32_t m_BusyWorkers{};
+		bool m_IsStopping{ false };
+	};
+}
@@ -1,5 +1,10 @@
 #pragma once
+#include <charconv>
+#include <chrono>
+#include <cstring>
 #include <fstream>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "Math.h"
@@ -31,10 +36,76 @@ namespace dae
 			return true;
 		}
 
-		//Just parses vertices and indices
 #pragma warning(push)
 #pragma warning(disable : 4505) //Warning unreferenced local function
-		static bool ParseOBJ(const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding = true)
+		//OBJ parsing helpers, they all work on the whole file read into memory at once
+		//pCurrent is moved past whatever got parsed, nothing is read past pEnd
+		static void SkipSpaces(const char*& pCurrent, const char* pEnd)
+		{
+			while (pCurrent < pEnd && (*pCurrent == ' ' || *pCurrent == '\t' || *pCurrent == '\r'))
+			{
+				++pCurrent;
+			}
+		}
+
+		static void SkipLine(const char*& pCurrent, const char* pEnd)
+		{
+			const char* pLineEnd{ static_cast<const char*>(memchr(pCurrent, '\n', pEnd - pCurrent)) };
+			pCurrent = pLineEnd ? pLineEnd + 1 : pEnd;
+		}
+
+		static float ParseFloat(const char*& pCurrent, const char* pEnd)
+		{
+			SkipSpaces(pCurrent, pEnd);
+			if (pCurrent < pEnd && *pCurrent == '+')
+			{
+				++pCurrent;
+			}
+
+			float value{};
+			pCurrent = std::from_chars(pCurrent, pEnd, value).ptr;
+			return value;
+		}
+
+		//Resolves 1-based and negative (relative to the end) OBJ indices to a 0-based index, -1 when missing or out of range
+		static int ParseIndex(const char*& pCurrent, const char* pEnd, size_t elementCount)
+		{
+			int index{};
+			const std::from_chars_result result{ std::from_chars(pCurrent, pEnd, index) };
+			if (result.ec != std::errc{})
+				return -1;
+
+			pCurrent = result.ptr;
+
+			const int64_t resolvedIndex{ index < 0 ? static_cast<int64_t>(elementCount) + index : static_cast<int64_t>(index) - 1 };
+			return (resolvedIndex >= 0 && resolvedIndex < static_cast<int64_t>(elementCount)) ? static_cast<int>(resolvedIndex) : -1;
+		}
+
+		//Position, uv & normal index of a face corner, -1 when the corner doesn't have one
+		struct OBJCorner
+		{
+			int position{ -1 };
+			int uv{ -1 };
+			int normal{ -1 };
+
+			bool operator==(const OBJCorner& other) const = default;
+		};
+
+		struct OBJCornerHash
+		{
+			size_t operator()(const OBJCorner& corner) const
+			{
+				size_t hash{ std::hash<int>{}(corner.position) };
+				hash = hash * 31 + std::hash<int>{}(corner.uv);
+				hash = hash * 31 + std::hash<int>{}(corner.normal);
+				return hash;
+			}
+		};
+
+		//Parses positions, uvs, normals and faces, quads & n-gons are split in a triangle fan
+		//Vertices are deduplicated, every unique (position, uv, normal) triplet is stored once and shared through the indices
+		//bounds gets the box of the final positions & a sphere around the box center
+		static bool ParseOBJ(const std::string& filename, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, Bounds& bounds, bool flipAxisAndWinding = true)
 		{
 #ifdef DISABLE_OBJ
 
@@ -44,10 +115,18 @@ namespace dae
 
 #else
 
-			std::ifstream file(filename);
+			const auto startTime{ std::chrono::steady_clock::now() };
+
+			//One read for the whole file, parsing then never goes back to the stream
+			std::ifstream file(filename, std::ios::binary | std::ios::ate);
 			if (!file)
 				return false;
 
+			std::vector<char> fileData(static_cast<size_t>(file.tellg()));
+			file.seekg(0);
+			if (!file.read(fileData.data(), fileData.size()))
+				return false;
+
 			std::vector<Vector3> positions{};
 			std::vector<Vector3> normals{};
 			std::vector<Vector2> UVs{};
@@ -55,99 +134,123 @@ namespace dae
 			vertices.clear();
 			indices.clear();
 
-			std::string sCommand;
-			// start a while iteration ending when the end of file is reached (ios::eof)
-			while (!file.eof())
+			const char* pCurrent{ fileData.data() };
+			const char* pEnd{ fileData.data() + fileData.size() };
+
+			std::vector<uint32_t> faceIndices{};
+			std::unordered_map<OBJCorner, uint32_t, OBJCornerHash> cornerVertices{};
+			while (pCurrent < pEnd)
 			{
-				//read the first word of the string, use the >> operator (istream::operator>>) 
-				file >> sCommand;
-				//use conditional statements to process the different commands	
-				if (sCommand == "#")
+				SkipSpaces(pCurrent, pEnd);
+
+				const char* pCommand{ pCurrent };
+				while (pCurrent < pEnd && *pCurrent != ' ' && *pCurrent != '\t' && *pCurrent != '\r' && *pCurrent != '\n')
 				{
-					// Ignore Comment
+					++pCurrent;
 				}
-				else if (sCommand == "v")
+				const std::string_view command{ pCommand, static_cast<size_t>(pCurrent - pCommand) };
+
+				if (command == "v")
 				{
 					//Vertex
-					float x, y, z;
-					file >> x >> y >> z;
+					const float x{ ParseFloat(pCurrent, pEnd) };
+					const float y{ ParseFloat(pCurrent, pEnd) };
+					const float z{ ParseFloat(pCurrent, pEnd) };
 
 					positions.emplace_back(x, y, z);
 				}
-				else if (sCommand == "vt")
+				else if (command == "vt")
 				{
 					// Vertex TexCoord
-					float u, v;
-					file >> u >> v;
+					const float u{ ParseFloat(pCurrent, pEnd) };
+					const float v{ ParseFloat(pCurrent, pEnd) };
+
 					UVs.emplace_back(u, 1 - v);
 				}
-				else if (sCommand == "vn")
+				else if (command == "vn")
 				{
 					// Vertex Normal
-					float x, y, z;
-					file >> x >> y >> z;
+					const float x{ ParseFloat(pCurrent, pEnd) };
+					const float y{ ParseFloat(pCurrent, pEnd) };
+					const float z{ ParseFloat(pCurrent, pEnd) };
 
 					normals.emplace_back(x, y, z);
 				}
-				else if (sCommand == "f")
+				else if (command == "f")
 				{
-					//if a face is read:
-					//construct the 3 vertices, add them to the vertex array
-					//add three indices to the index array
-					//add the material index as attibute to the attribute array
-					//
-					// Faces or triangles
-					Vertex vertex{};
-					size_t iPosition, iTexCoord, iNormal;
-
-					uint32_t tempIndices[3];
-					for (size_t iFace = 0; iFace < 3; iFace++)
+					//Every corner is "position[/[uv][/normal]]", corners that reuse the same triplet share one vertex
+					faceIndices.clear();
+					while (true)
 					{
-						// OBJ format uses 1-based arrays
-						file >> iPosition;
-						vertex.position = positions[iPosition - 1];
+						SkipSpaces(pCurrent, pEnd);
+
+						OBJCorner corner{};
+						corner.position = ParseIndex(pCurrent, pEnd, positions.size());
+						if (corner.position < 0)
+							break;
 
-						if ('/' == file.peek())//is next in buffer ==  '/' ?
+						if (pCurrent < pEnd && *pCurrent == '/')
 						{
-							file.ignore();//read and ignore one element ('/')
+							++pCurrent;
 
-							if ('/' != file.peek())
+							// Optional texture coordinate
+							if (pCurrent < pEnd && *pCurrent != '/')
 							{
-								// Optional texture coordinate
-								file >> iTexCoord;
-								vertex.uv = UVs[iTexCoord - 1];
+								corner.uv = ParseIndex(pCurrent, pEnd, UVs.size());
 							}
 
-							if ('/' == file.peek())
+							// Optional vertex normal
+							if (pCurrent < pEnd && *pCurrent == '/')
 							{
-								file.ignore();
+								++pCurrent;
+								corner.normal = ParseIndex(pCurrent, pEnd, normals.size());
+							}
+						}
 
-								// Optional vertex normal
-								file >> iNormal;
-								vertex.normal = normals[iNormal - 1];
+						const auto [it, isNewCorner] { cornerVertices.try_emplace(corner, uint32_t(vertices.size())) };
+						if (isNewCorner)
+						{
+							Vertex vertex{};
+							vertex.position = positions[corner.position];
+							if (corner.uv >= 0)
+							{
+								vertex.uv = UVs[corner.uv];
 							}
+							if (corner.normal >= 0)
+							{
+								vertex.normal = normals[corner.normal];
+							}
+
+							vertices.push_back(vertex);
 						}
 
-						vertices.push_back(vertex);
-						tempIndices[iFace] = uint32_t(vertices.size()) - 1;
-						//indices.push_back(uint32_t(vertices.size()) - 1);
+						faceIndices.push_back(it->second);
 					}
 
-					indices.push_back(tempIndices[0]);
-					if (flipAxisAndWinding)
-					{
-						indices.push_back(tempIndices[2]);
-						indices.push_back(tempIndices[1]);
-					}
-					else
+					for (size_t iCorner = 2; iCorner < faceIndices.size(); ++iCorner)
 					{
-						indices.push_back(tempIndices[1]);
-						indices.push_back(tempIndices[2]);
+						indices.push_back(faceIndices[0]);
+						if (flipAxisAndWinding)
+						{
+							indices.push_back(faceIndices[iCorner]);
+							indices.push_back(faceIndices[iCorner - 1]);
+						}
+						else
+						{
+							indices.push_back(faceIndices[iCorner - 1]);
+							indices.push_back(faceIndices[iCorner]);
+						}
 					}
 				}
-				//read till end of line and ignore all remaining chars
-				file.ignore(1000, '\n');
+				//Comments and unsupported commands, skip the rest of the line
+				SkipLine(pCurrent, pEnd);
 			}
+
+			const float parseSeconds{ std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count() };
+			const float fileMegaBytes{ fileData.size() / (1024.f * 1024.f) };
+			std::cout << "Parsed " << filename << " (" << fileMegaBytes << " MB) in " << parseSeconds * 1000.f << "ms, " << fileMegaBytes / std::max(parseSeconds, FLT_EPSILON) << " MB/s, "
+				<< vertices.size() << " vertices for " << indices.size() << " indices\n";
+
 			//Cheap Tangent Calculations
 			for (uint32_t i = 0; i < indices.size(); i += 3)
 			{
@@ -166,9 +269,13 @@ namespace dae
 				const Vector3 edge1 = p2 - p0;
 				const Vector2 diffX = Vector2(uv1.x - uv0.x, uv2.x - uv0.x);
 				const Vector2 diffY = Vector2(uv1.y - uv0.y, uv2.y - uv0.y);
-				float r = 1.f / Vector2::Cross(diffX, diffY);
+				const float uvArea{ Vector2::Cross(diffX, diffY) };
 
+				//Triangles without uv area have no tangent direction, they would spread inf/NaN to every vertex they share
+				if (std::abs(uvArea) < FLT_EPSILON)
+					continue;
 
+				float r = 1.f / uvArea;
 				Vector3 tangent = (edge0 * diffY.y - edge1 * diffY.x) * r;
 				vertices[index0].tangent += tangent;
 				vertices[index1].tangent += tangent;
@@ -177,7 +284,14 @@ namespace dae
 			//Fix the tangents per vertex now because we accumulated
 			for (auto& v : vertices)
 			{
-				v.tangent = Vector3::Reject(v.tangent, v.normal).Normalized();
+				v.tangent = Vector3::Reject(v.tangent, v.normal);
+
+				//Nothing accumulated (or it was parallel to the normal), any direction in the surface will do
+				if (v.tangent.SqrMagnitude() < FLT_EPSILON)
+				{
+					v.tangent = Vector3::Reject(std::abs(v.normal.x) < 0.9f ? Vector3::UnitX : Vector3::UnitY, v.normal);
+				}
+				v.tangent.Normalize();
 				if (flipAxisAndWinding)
 				{
 					v.position.z *= -1.f;
@@ -187,6 +301,21 @@ namespace dae
 
 			}
 
+			//After the axis flip, so they match the positions that get rendered
+			bounds = {};
+			for (const Vertex& vertex : vertices)
+			{
+				bounds.Grow(vertex.position);
+			}
+
+			bounds.center = (bounds.min + bounds.max) * 0.5f;
+			float squaredRadius{};
+			for (const Vertex& vertex : vertices)
+			{
+				squaredRadius = std::max(squaredRadius, (vertex.position - bounds.center).SqrMagnitude());
+			}
+			bounds.radius = sqrtf(squaredRadius);
+
 			return true;
 #endif
 		}
@@ -200,11 +329,46 @@ namespace dae
 			return cd * kd / PI;
 		}
 
-		inline ColorRGB Phong(float ks, float exp, const Vector3& l, const Vector3& v, const Vector3& n)
+		//Largest absolute error FastPow may have for a base in [0, 1] & an exponent in [0, 25], half an 8 bit level
+		//--benchmark-specular checks it against powf
+		constexpr float FAST_POW_MAX_ERROR{ 0.5f / 255.f };
+
+		//powf for bases in [0, 1], as exp2(exponent * log2(base)) with polynomial log2 & exp2
+		inline float FastPow(float base, float exponent)
+		{
+			if (base <= 0.f)
+				return exponent == 0.f ? 1.f : 0.f;
+
+			//log2: the float's exponent field, plus a polynomial over its mantissa in [1, 2)
+			uint32_t bits{};
+			std::memcpy(&bits, &base, sizeof(float));
+			const float baseExponent{ static_cast<float>(static_cast<int>(bits >> 23) - 127) };
+
+			bits = (bits & 0x007FFFFF) | 0x3F800000;
+			float mantissa{};
+			std::memcpy(&mantissa, &bits, sizeof(float));
+
+			const float t{ mantissa - 1.f };
+			const float log2Base{ baseExponent + t * (1.44159208f + t * (-0.70725343f + t * (0.41156148f + t * (-0.18983244f + t * 0.04392863f)))) };
+
+			//exp2: the integer part goes straight into an exponent field, a polynomial handles the fraction
+			const float power{ std::max(exponent * log2Base, -126.f) };
+			const float integerPart{ std::floor(power) };
+			const float fraction{ power - integerPart };
+			const float fractionPower{ 1.f + fraction * (0.69296955f + fraction * (0.24162132f + fraction * (0.05171774f + fraction * 0.01368398f))) };
+
+			bits = static_cast<uint32_t>(static_cast<int>(integerPart) + 127) << 23;
+			float scale{};
+			std::memcpy(&scale, &bits, sizeof(float));
+
+			return fractionPower * scale;
+		}
+
+		inline ColorRGB Phong(float ks, float exp, const Vector3& l, const Vector3& v, const Vector3& n, SpecularPrecision precision = SpecularPrecision::Exact)
 		{
 			const Vector3 reflectVector(Vector3::Reflect(l, n));
 			const float reflectView{ Vector3::DotClamped(reflectVector, v) };
-			const float phong{ ks * powf(reflectView, exp) };
+			const float phong{ ks * (precision == SpecularPrecision::Fast ? FastPow(reflectView, exp) : powf(reflectView, exp)) };
 
 			return ColorRGB{ phong, phong, phong };
 		}
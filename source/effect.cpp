@@ -1,4 +1,6 @@
 #include "pch.h"
+
+#if !defined(SOFTWARE_ONLY)
 #include "effect.h"
 
 effect::effect(ID3D11Device* pDevice, const std::wstring& assetFile)
@@ -61,65 +63,67 @@ void effect::SetDiffuseMap(DirectX_Texture* pDiffuseTexture)
 		m_pDiffuseMapVariable->SetResource(pDiffuseTexture->GetShaderResourceView());
 }
 
-void effect::CycleFilteringMethod()
+void effect::SetFilteringMethod(FilteringMethod filteringMethod)
 {
-	m_FilteringMethod = static_cast<FilteringMethod>((static_cast<int>(m_FilteringMethod) + 1) % (static_cast<int>(FilteringMethod::ANISOTROPIC) + 1));
-	std::cout << "Filtering Method: ";
-
-	switch (m_FilteringMethod)
+	switch (filteringMethod)
 	{
 	case FilteringMethod::POINT:
 		m_pTechnique = m_pEffect->GetTechniqueByName("PointFilteringTechnique");
 		
 		if (!m_pTechnique->IsValid()) 
 			std::wcout << L"PointTechnique not valid\n";
-		
-		std::cout << "POINT\n";
 		break;
-	case FilteringMethod::LINEAR:
+	case FilteringMethod::BILINEAR:
+	case FilteringMethod::TRILINEAR:
 		m_pTechnique = m_pEffect->GetTechniqueByName("LinearFilteringTechnique");
 		
 		if (!m_pTechnique->IsValid()) 
 			std::wcout << L"LinearTechnique not valid\n";
-		
-		std::cout << "LINEAR\n";
 		break;
 	case FilteringMethod::ANISOTROPIC:
 		m_pTechnique = m_pEffect->GetTechniqueByName("AnisotropicFilteringTechnique");
 		
 		if (!m_pTechnique->IsValid())
 			std::wcout << L"AnisotropicTechnique not valid\n";
-		std::cout << "ANISOTROPIC\n";
-
 		break;
 	}
 }
 
-void effect::CycleCullMode()
+void effect::SetCullMode(CullMode cullMode)
 {
-	ID3D11RasterizerState* pState;
+	ID3D11RasterizerState* pState{};
 	m_pRasterizerDesc->GetRasterizerState(0, &pState);
+	if (!pState)
+		return;
 
-	D3D11_RASTERIZER_DESC pRasterizerDesc;
-	pState->GetDesc(&pRasterizerDesc);
+	D3D11_RASTERIZER_DESC rasterizerDesc{};
+	pState->GetDesc(&rasterizerDesc);
 
-	m_CullMode = static_cast<CullMode>((static_cast<int>(m_CullMode) + 1) % (static_cast<int>(CullMode::Back) + 1));
-	std::cout << "Switched Cullmode to ";
-	switch (m_CullMode)
+	switch (cullMode)
 	{
-	case effect::CullMode::Off:
-		std::cout << "Off\n";
-		pRasterizerDesc.CullMode = D3D11_CULL_NONE;
+	case CullMode::Off:
+		rasterizerDesc.CullMode = D3D11_CULL_NONE;
 		break;
-	case effect::CullMode::Front:
-		std::cout << "Front\n";
-		pRasterizerDesc.CullMode = D3D11_CULL_FRONT;
+	case CullMode::Front:
+		rasterizerDesc.CullMode = D3D11_CULL_FRONT;
 		break;
-	case effect::CullMode::Back:
-		std::cout << "Back\n";
-		pRasterizerDesc.CullMode = D3D11_CULL_BACK;
+	case CullMode::Back:
+		rasterizerDesc.CullMode = D3D11_CULL_BACK;
 		break;
 	}
 
-	m_pRasterizerDesc->SetRasterizerState(0, pState);
-}
\ No newline at end of file
+	//States are immutable, the changed description needs a new one
+	ID3D11Device* pDevice{};
+	pState->GetDevice(&pDevice);
+
+	ID3D11RasterizerState* pNewState{};
+	if (SUCCEEDED(pDevice->CreateRasterizerState(&rasterizerDesc, &pNewState)))
+	{
+		m_pRasterizerDesc->SetRasterizerState(0, pNewState);
+		pNewState->Release();
+	}
+
+	pDevice->Release();
+	pState->Release();
+}
+#endif
@@ -1,4 +1,5 @@
 #pragma once
+#include "DataTypes.h"
 #include "Textures.h"
 using namespace dae;
 
@@ -23,27 +24,10 @@ public:
 
 	void SetDiffuseMap(DirectX_Texture* pTexture);
 
-	void CycleFilteringMethod();
-	void CycleCullMode();
+	void SetFilteringMethod(FilteringMethod filteringMethod);
+	void SetCullMode(CullMode cullMode);
 
 protected:
-	enum class FilteringMethod
-	{
-		POINT,
-		LINEAR,
-		ANISOTROPIC
-	};
-
-	enum class CullMode
-	{
-		Off,
-		Front,
-		Back
-	};
-	CullMode m_CullMode;
-
-	FilteringMethod m_FilteringMethod{ FilteringMethod::POINT };
-
 	ID3DX11Effect* m_pEffect;
 	ID3DX11EffectTechnique* m_pTechnique;
 	ID3DX11EffectMatrixVariable* m_pMatWorldViewProjVariable;
@@ -7,6 +7,9 @@
 
 #undef main
 #include "Renderer.h"
+#include "CameraScript.h"
+
+#include <chrono>
 
 using namespace dae;
 
@@ -16,11 +19,380 @@ void ShutDown(SDL_Window* pWindow)
 	SDL_Quit();
 }
 
+//Spreads point & spot lights over a shell around the vehicle, every third one a spot aimed at its center
+void AddLightShell(Renderer* pRenderer, int lightCount)
+{
+	const float shellRadius{ 22.f };
+	const float goldenAngle{ PI * (3.f - sqrtf(5.f)) };
+
+	for (int index{ 0 }; index < lightCount; ++index)
+	{
+		//Fibonacci sphere, evenly spaced without clumping at the poles
+		const float height{ 1.f - 2.f * (index + 0.5f) / lightCount };
+		const float ringRadius{ sqrtf(1.f - height * height) };
+		const float angle{ goldenAngle * index };
+
+		Light light{};
+		light.type = index % 3 == 2 ? LightType::Spot : LightType::Point;
+		light.position = Vector3{ cosf(angle) * ringRadius, height, sinf(angle) * ringRadius } * shellRadius;
+		light.direction = -light.position.Normalized();
+		light.color = { 0.5f + 0.5f * cosf(angle), 0.5f + 0.5f * cosf(angle + 2.094f), 0.5f + 0.5f * cosf(angle + 4.189f) };
+		light.intensity = 20.f;
+		light.range = 12.f;
+		light.cosInnerCone = cosf(20.f * TO_RADIANS);
+		light.cosOuterCone = cosf(30.f * TO_RADIANS);
+		pRenderer->AddLight(light);
+	}
+}
+
+//Replaces the single vehicle by a parking lot of scaled down vehicles, rows of them in front of & below the camera
+void AddParkingLot(Renderer* pRenderer, int vehicleCount)
+{
+	const int columnCount{ 25 };
+	const float scale{ 0.1f };
+	const float spacingX{ 5.f };
+	const float spacingZ{ 4.5f };
+
+	pRenderer->ClearInstances();
+	for (int index{ 0 }; index < vehicleCount; ++index)
+	{
+		const int column{ index % columnCount };
+		const int row{ index / columnCount };
+
+		//Every other row faces the other way, like cars parked nose to nose
+		const Vector3 position{ (column - (columnCount - 1) * 0.5f) * spacingX, -6.f, -40.f + row * spacingZ };
+		const float yaw{ row % 2 ? 180.f : 0.f };
+		pRenderer->AddInstance(Matrix::CreateScale(scale, scale, scale) * Matrix::CreateRotationY(yaw * TO_RADIANS) * Matrix::CreateTranslation(position));
+	}
+}
+
+//Renders a fixed amount of frames with the software rasterizer without a window or DirectX
+//Usage: --headless [--size WIDTHxHEIGHT] [--frames COUNT] [--camera SCRIPT] [--output PREFIX] [--filtering point|bilinear|trilinear|anisotropic] [--pipeline forward|deferred|visibility] [--specular exact|fast] [--lights COUNT] [--instances COUNT] [--async-assets]
+//--async-assets starts rendering while the assets are still loading instead of waiting for them, the first frames show placeholders
+int RunHeadless(int argc, char* args[])
+{
+	int width{ 640 };
+	int height{ 480 };
+	int frameCount{ 1 };
+	bool hasFrameCount{ false };
+	std::string outputPrefix{ "frame" };
+	FilteringMethod filteringMethod{ FilteringMethod::POINT };
+	ShadingPipeline shadingPipeline{ ShadingPipeline::Forward };
+	SpecularPrecision specularPrecision{ SpecularPrecision::Fast };
+	int lightCount{};
+	int instanceCount{};
+	bool waitForAssets{ true };
+	CameraScript cameraScript{};
+
+	for (int index{ 1 }; index < argc; ++index)
+	{
+		const std::string argument{ args[index] };
+		const bool hasValue{ index + 1 < argc };
+
+		if (argument == "--size" && hasValue)
+		{
+			std::istringstream sizeStream{ args[++index] };
+			char separator{};
+			if (!(sizeStream >> width >> separator >> height) || separator != 'x' || width <= 0 || height <= 0)
+			{
+				std::cout << "Invalid size, expected WIDTHxHEIGHT\n";
+				return 1;
+			}
+		}
+		else if (argument == "--frames" && hasValue)
+		{
+			frameCount = std::max(std::atoi(args[++index]), 0);
+			hasFrameCount = true;
+		}
+		else if (argument == "--camera" && hasValue)
+		{
+			if (!cameraScript.LoadFromFile(args[++index]))
+			{
+				std::cout << "Failed to load camera script: " << args[index] << '\n';
+				return 1;
+			}
+		}
+		else if (argument == "--output" && hasValue)
+		{
+			outputPrefix = args[++index];
+		}
+		else if (argument == "--filtering" && hasValue)
+		{
+			const std::string name{ args[++index] };
+			if (name == "point")				filteringMethod = FilteringMethod::POINT;
+			else if (name == "bilinear")		filteringMethod = FilteringMethod::BILINEAR;
+			else if (name == "trilinear")		filteringMethod = FilteringMethod::TRILINEAR;
+			else if (name == "anisotropic")		filteringMethod = FilteringMethod::ANISOTROPIC;
+			else
+			{
+				std::cout << "Invalid filtering, expected point, bilinear, trilinear or anisotropic\n";
+				return 1;
+			}
+		}
+		else if (argument == "--pipeline" && hasValue)
+		{
+			const std::string name{ args[++index] };
+			if (name == "forward")				shadingPipeline = ShadingPipeline::Forward;
+			else if (name == "deferred")		shadingPipeline = ShadingPipeline::Deferred;
+			else if (name == "visibility")		shadingPipeline = ShadingPipeline::VisibilityBuffer;
+			else
+			{
+				std::cout << "Invalid pipeline, expected forward, deferred or visibility\n";
+				return 1;
+			}
+		}
+		else if (argument == "--lights" && hasValue)
+		{
+			lightCount = std::max(std::atoi(args[++index]), 0);
+		}
+		else if (argument == "--instances" && hasValue)
+		{
+			instanceCount = std::max(std::atoi(args[++index]), 0);
+		}
+		else if (argument == "--async-assets")
+		{
+			waitForAssets = false;
+		}
+		else if (argument == "--specular" && hasValue)
+		{
+			const std::string name{ args[++index] };
+			if (name == "exact")				specularPrecision = SpecularPrecision::Exact;
+			else if (name == "fast")			specularPrecision = SpecularPrecision::Fast;
+			else
+			{
+				std::cout << "Invalid specular precision, expected exact or fast\n";
+				return 1;
+			}
+		}
+	}
+
+	if (!hasFrameCount && !cameraScript.IsEmpty())
+	{
+		frameCount = cameraScript.GetLastFrame() + 1;
+	}
+
+	//Fixed timestep so every run produces the same frames
+	const float frameTime{ 1.f / 30.f };
+
+	const auto startTime{ std::chrono::steady_clock::now() };
+
+	const auto pTimer = new Timer();
+	const auto pRenderer = new Renderer(width, height);
+	//By default every frame shows the real assets, so the output is the same from run to run
+	if (waitForAssets)
+	{
+		pRenderer->WaitForAssets();
+	}
+	pRenderer->SetFilteringMethod(filteringMethod);
+	pRenderer->SetShadingPipeline(shadingPipeline);
+	pRenderer->SetSpecularPrecision(specularPrecision);
+	AddLightShell(pRenderer, lightCount);
+	if (instanceCount > 0)
+	{
+		AddParkingLot(pRenderer, instanceCount);
+	}
+
+	pTimer->Start();
+	for (int frame{ 0 }; frame < frameCount; ++frame)
+	{
+		if (!cameraScript.IsEmpty())
+		{
+			const CameraKey key{ cameraScript.Evaluate(frame) };
+			pRenderer->SetCameraTransform(key.origin, key.pitch, key.yaw);
+		}
+
+		pRenderer->UpdateHeadless(frameTime);
+		pRenderer->Render();
+
+		if (frame == 0)
+		{
+			std::cout << "First frame after " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count() << " ms\n";
+		}
+
+		char fileName[16]{};
+		snprintf(fileName, sizeof(fileName), "_%04d.bmp", frame);
+		if (!pRenderer->SaveBackBuffer(outputPrefix + fileName))
+		{
+			std::cout << "Failed to save frame " << frame << ": " << SDL_GetError() << '\n';
+		}
+	}
+	pTimer->Update();
+	pTimer->Stop();
+
+	std::cout << "Rendered " << frameCount << " frames (" << width << 'x' << height << ") in " << pTimer->GetTotal() << "s\n";
+
+	delete pRenderer;
+	delete pTimer;
+
+	SDL_Quit();
+	return 0;
+}
+
+//Samples a texture the way a rotated, screen filling quad would, once per texture layout
+//Usage: --benchmark-textures [TEXTURE]
+int RunTextureBenchmark(int argc, char* args[])
+{
+	std::string path{ "Resources/vehicle_diffuse.png" };
+	for (int index{ 1 }; index + 1 < argc; ++index)
+	{
+		if (std::string{ args[index] } == "--benchmark-textures" && args[index + 1][0] != '-')
+		{
+			path = args[index + 1];
+		}
+	}
+
+	const TextureLayout layouts[]{ TextureLayout::Linear, TextureLayout::Tiled };
+	Software_Texture* pTextures[2]{};
+	for (int layout{ 0 }; layout < 2; ++layout)
+	{
+		pTextures[layout] = Software_Texture::LoadFromFile(path, layouts[layout]);
+		if (!pTextures[layout])
+		{
+			delete pTextures[0];
+			return 1;
+		}
+	}
+
+	//One texel per pixel, so every pass reads the full resolution level along rotated rows
+	const int size{ 1024 };
+	const float texelSize{ 1.f / size };
+
+	std::cout << "Texture layout benchmark: " << path << ", " << size << 'x' << size << " samples per pass\n";
+	std::cout << "angle\tfilter\t\tlinear (ms)\ttiled (ms)\n";
+
+	float checksum{};
+	const auto samplePass{ [&](int layout, const Vector2& stepX, const Vector2& stepY, FilteringMethod filteringMethod)
+		{
+			for (int py{ 0 }; py < size; ++py)
+			{
+				for (int px{ 0 }; px < size; ++px)
+				{
+					const Vector2 uv{ stepX * static_cast<float>(px) + stepY * static_cast<float>(py) };
+					checksum += pTextures[layout]->Sample(uv, stepX, stepY, filteringMethod).channels[0];
+				}
+			}
+		} };
+
+	//Untimed pass over both layouts first, so neither pays for the page faults & cold caches
+	for (int layout{ 0 }; layout < 2; ++layout)
+	{
+		samplePass(layout, Vector2{ texelSize, 0.f }, Vector2{ 0.f, texelSize }, FilteringMethod::BILINEAR);
+	}
+
+	int passIndex{ 0 };
+	for (const FilteringMethod filteringMethod : { FilteringMethod::POINT, FilteringMethod::BILINEAR })
+	{
+		for (int angle{ 0 }; angle <= 90; angle += 15)
+		{
+			const float radians{ angle * TO_RADIANS };
+			const Vector2 stepX{ cosf(radians) * texelSize, sinf(radians) * texelSize };
+			const Vector2 stepY{ -sinf(radians) * texelSize, cosf(radians) * texelSize };
+
+			//Layouts take turns going first, so whatever the first one leaves in cache doesn't always favor the same one
+			double milliseconds[2]{};
+			for (int order{ 0 }; order < 2; ++order)
+			{
+				const int layout{ (order + passIndex) % 2 };
+
+				const auto start{ std::chrono::steady_clock::now() };
+				samplePass(layout, stepX, stepY, filteringMethod);
+				milliseconds[layout] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			}
+			++passIndex;
+
+			std::cout << angle << '\t' << (filteringMethod == FilteringMethod::POINT ? "point\t" : "bilinear") << '\t' << milliseconds[0] << "\t\t" << milliseconds[1] << '\n';
+		}
+	}
+
+	//Keeps the samples from being optimized away
+	std::cout << "checksum " << checksum << '\n';
+
+	delete pTextures[0];
+	delete pTextures[1];
+	return 0;
+}
+
+//Compares LightingUtils::FastPow with powf over the range the specular lobe uses, fails when the error bound is exceeded
+//Usage: --benchmark-specular
+int RunSpecularBenchmark()
+{
+	const int baseCount{ 4096 };
+	const int exponentCount{ 256 };
+	const float maxExponent{ 25.f };
+
+	std::vector<float> bases(baseCount);
+	for (int index{ 0 }; index < baseCount; ++index)
+	{
+		bases[index] = static_cast<float>(index) / (baseCount - 1);
+	}
+
+	float maxError{};
+	float maxErrorBase{};
+	float maxErrorExponent{};
+	for (int exponentIndex{ 0 }; exponentIndex < exponentCount; ++exponentIndex)
+	{
+		const float exponent{ maxExponent * exponentIndex / (exponentCount - 1) };
+		for (const float base : bases)
+		{
+			const float error{ std::abs(LightingUtils::FastPow(base, exponent) - powf(base, exponent)) };
+			if (error > maxError)
+			{
+				maxError = error;
+				maxErrorBase = base;
+				maxErrorExponent = exponent;
+			}
+		}
+	}
+
+	//Same grid again, timed
+	float checksum{};
+	double milliseconds[2]{};
+	for (int method{ 0 }; method < 2; ++method)
+	{
+		const auto start{ std::chrono::steady_clock::now() };
+		for (int exponentIndex{ 0 }; exponentIndex < exponentCount; ++exponentIndex)
+		{
+			const float exponent{ maxExponent * exponentIndex / (exponentCount - 1) };
+			for (const float base : bases)
+			{
+				checksum += method == 0 ? powf(base, exponent) : LightingUtils::FastPow(base, exponent);
+			}
+		}
+		milliseconds[method] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	std::cout << "Specular power benchmark: " << baseCount << " bases x " << exponentCount << " exponents in [0, " << maxExponent << "]\n";
+	std::cout << "powf " << milliseconds[0] << " ms, FastPow " << milliseconds[1] << " ms\n";
+	std::cout << "max error " << maxError << " at pow(" << maxErrorBase << ", " << maxErrorExponent << "), bound " << LightingUtils::FAST_POW_MAX_ERROR << '\n';
+
+	//Keeps the results from being optimized away
+	std::cout << "checksum " << checksum << '\n';
+
+	if (maxError > LightingUtils::FAST_POW_MAX_ERROR)
+	{
+		std::cout << "FastPow exceeds its error bound\n";
+		return 1;
+	}
+	return 0;
+}
+
 int main(int argc, char* args[])
 {
-	//Unreferenced parameters
-	(void)argc;
-	(void)args;
+	for (int index{ 1 }; index < argc; ++index)
+	{
+		if (std::string{ args[index] } == "--headless")
+		{
+			return RunHeadless(argc, args);
+		}
+		if (std::string{ args[index] } == "--benchmark-textures")
+		{
+			return RunTextureBenchmark(argc, args);
+		}
+		if (std::string{ args[index] } == "--benchmark-specular")
+		{
+			return RunSpecularBenchmark();
+		}
+	}
 
 	//Create window + surfaces
 	SDL_Init(SDL_INIT_VIDEO);
@@ -102,6 +474,10 @@ int main(int argc, char* args[])
 				{
 					pRenderer->TogglePrintFPS();
 				}
+				else if (e.key.keysym.scancode == SDL_SCANCODE_F12)
+				{
+					pRenderer->CycleShadingPipeline();
+				}
 
 				break;
 			default: ;
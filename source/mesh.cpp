@@ -1,9 +1,20 @@
 #include "pch.h"
+
+#if !defined(SOFTWARE_ONLY)
 #include "mesh.h"
 
-mesh::mesh(ID3D11Device* pDevice, std::vector<dae::Vertex>& vertices, const std::vector<uint32_t>& indices, effect* pEffect)
+//Vertices & indices are only read during construction, so they can point straight into a mapped MeshCache
+mesh::mesh(ID3D11Device* pDevice, const dae::Vertex* pVertices, uint32_t vertexCount, const uint32_t* pIndices, uint32_t indexCount, const MeshLod* pLods, uint32_t lodCount, const Bounds& bounds, effect* pEffect)
 	: m_pEffect{ pEffect }
+	, m_Bounds{ bounds }
+	, m_Lods{ pLods, pLods + lodCount }
 {
+	//Without levels the whole buffer is level 0
+	if (m_Lods.empty())
+	{
+		m_Lods.push_back({ 0, indexCount, 0, vertexCount });
+	}
+
 	//Create Vertex Layout
 	static constexpr uint32_t numElements{ 4 };
 	D3D11_INPUT_ELEMENT_DESC vertexDesc[numElements]{};
@@ -48,26 +59,25 @@ mesh::mesh(ID3D11Device* pDevice, std::vector<dae::Vertex>& vertices, const std:
 	//Create vertex buffer
 	D3D11_BUFFER_DESC bd{};
 	bd.Usage = D3D11_USAGE_IMMUTABLE;
-	bd.ByteWidth = sizeof(Vertex) * static_cast<uint32_t>(vertices.size());
+	bd.ByteWidth = sizeof(Vertex) * vertexCount;
 	bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 	bd.CPUAccessFlags = 0;
 	bd.MiscFlags = 0;
 
 	D3D11_SUBRESOURCE_DATA initData{};
-	initData.pSysMem = vertices.data();
+	initData.pSysMem = pVertices;
 
 	result = pDevice->CreateBuffer(&bd, &initData, &m_pVertexBuffer);
 	if (FAILED(result))
 		return;
 
 	// Create index buffer
-	m_NumIndices = static_cast<uint32_t>(indices.size());
 	bd.Usage = D3D11_USAGE_IMMUTABLE;
-	bd.ByteWidth = sizeof(uint32_t) * m_NumIndices;
+	bd.ByteWidth = sizeof(uint32_t) * indexCount;
 	bd.BindFlags = D3D11_BIND_INDEX_BUFFER;
 	bd.CPUAccessFlags = 0;
 	bd.MiscFlags = 0;
-	initData.pSysMem = indices.data();
+	initData.pSysMem = pIndices;
 
 	result = pDevice->CreateBuffer(&bd, &initData, &m_pIndexBuffer);
 	if (FAILED(result))
@@ -95,7 +105,7 @@ mesh::~mesh()
 	}
 }
 
-void mesh::Render(ID3D11DeviceContext* pDeviceContext)
+void mesh::Render(ID3D11DeviceContext* pDeviceContext, uint32_t lod)
 {
 	//1. Set Primitive Topology
 	pDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
@@ -111,16 +121,32 @@ void mesh::Render(ID3D11DeviceContext* pDeviceContext)
 	//4. Set IndexBuffer
 	pDeviceContext->IASetIndexBuffer(m_pIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
 
-	//5. Draw
+	//5. Draw, the level's indices already point at its own vertices
+	const MeshLod& level{ m_Lods[std::min(lod, static_cast<uint32_t>(m_Lods.size()) - 1)] };
 	D3DX11_TECHNIQUE_DESC techDesc{};
 	m_pEffect->GetTechnique()->GetDesc(&techDesc);
 	for (UINT p = 0; p < techDesc.Passes; ++p)
 	{
 		m_pEffect->GetTechnique()->GetPassByIndex(p)->Apply(0, pDeviceContext);
-		pDeviceContext->DrawIndexed(m_NumIndices, 0, 0);
+		pDeviceContext->DrawIndexed(level.indexCount, level.firstIndex, 0);
 	}
 }
 
+bool mesh::IsVisible(const Frustum& frustum) const
+{
+	const Bounds worldBounds{ m_Bounds.Transformed(m_ScaleMatrix * m_RotationMatrix * m_TranslationMatrix) };
+
+	uint32_t insideMask{};
+	return frustum.IntersectsSphere(worldBounds.center, worldBounds.radius) && frustum.IntersectsBox(worldBounds.min, worldBounds.max, insideMask);
+}
+
+uint32_t mesh::SelectLod(const Camera& camera)
+{
+	const Bounds worldBounds{ m_Bounds.Transformed(m_ScaleMatrix * m_RotationMatrix * m_TranslationMatrix) };
+	m_Lod = MeshLod::Select(camera.GetScreenSize(worldBounds.center, worldBounds.radius), static_cast<uint32_t>(m_Lods.size()), m_Lod);
+	return m_Lod;
+}
+
 void mesh::UpdateMatrices(const Matrix& WorldViewProjection, const Matrix& invView)
 {
 	Matrix matWorld{ m_ScaleMatrix * m_RotationMatrix * m_TranslationMatrix };
@@ -145,12 +171,13 @@ void mesh::RotateZ(float angle)
 	m_RotationMatrix = Matrix::CreateRotationZ(angle) * m_RotationMatrix;
 }
 
-void mesh::CycleFilteringMethod()
+void mesh::SetFilteringMethod(FilteringMethod filteringMethod)
 {
-	m_pEffect->CycleFilteringMethod();
+	m_pEffect->SetFilteringMethod(filteringMethod);
 }
 
-void mesh::CycleCullMode()
+void mesh::SetCullMode(CullMode cullMode)
 {
-	m_pEffect->CycleCullMode();
-}
\ No newline at end of file
+	m_pEffect->SetCullMode(cullMode);
+}
+#endif
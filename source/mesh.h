@@ -1,5 +1,6 @@
 #pragma once
 #include "DataTypes.h"
+#include "Camera.h"
 #include "Effect_Shaded.h"
 #include <vector>
 
@@ -8,15 +9,22 @@ using namespace dae;
 class mesh final
 {
 public:
-	mesh(ID3D11Device* pDevice, std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, effect* pEffect);
+	//The levels of detail point into the vertices & indices, all of them go into the same buffers
+	mesh(ID3D11Device* pDevice, const Vertex* pVertices, uint32_t vertexCount, const uint32_t* pIndices, uint32_t indexCount, const MeshLod* pLods, uint32_t lodCount, const Bounds& bounds, effect* pEffect);
 	~mesh();
 
-	void Render(ID3D11DeviceContext* pDeviceContext);
+	void Render(ID3D11DeviceContext* pDeviceContext, uint32_t lod = 0);
+
+	//Object space bounds moved by the current world matrix, tested against the frustum before drawing
+	bool IsVisible(const Frustum& frustum) const;
+
+	//Level of detail for how large the bounds currently are on screen, remembered for the hysteresis of the next selection
+	uint32_t SelectLod(const Camera& camera);
 
 	void UpdateMatrices(const Matrix& WorldViewProjection, const Matrix& invView);
 
-	void CycleFilteringMethod();
-	void CycleCullMode();
+	void SetFilteringMethod(FilteringMethod filteringMethod);
+	void SetCullMode(CullMode cullMode);
 
 	void RotateX(float angle);
 	void RotateY(float angle);
@@ -24,6 +32,9 @@ public:
 
 private:
 	effect* m_pEffect{};	
+	Bounds m_Bounds{};
+	std::vector<MeshLod> m_Lods{};
+	uint32_t m_Lod{};
 
 	Matrix m_TranslationMatrix{ Vector3::UnitX, Vector3::UnitY, Vector3::UnitZ, Vector3::Zero };
 	Matrix m_RotationMatrix{ Vector3::UnitX, Vector3::UnitY, Vector3::UnitZ, Vector3::Zero };
@@ -32,7 +43,6 @@ private:
 	ID3D11InputLayout* m_pInputLayout{};
 	ID3D11Buffer* m_pVertexBuffer{};
 
-	uint32_t m_NumIndices{};
 	ID3D11Buffer* m_pIndexBuffer{};
 };
 
@@ -5,19 +5,29 @@
 #include <algorithm>
 #include <sstream>
 #include <memory>
+#include <string>
+#include <cfloat>
+
+//DirectX is only available on windows, other platforms build the software rasterizer only
+#if !defined(_WIN32) && !defined(SOFTWARE_ONLY)
+	#define SOFTWARE_ONLY
+#endif
+
 #define NOMINMAX  //for directx
 
 // SDL Headers
 #include "SDL.h"
-#include "SDL_syswm.h"
 #include "SDL_surface.h"
 #include "SDL_image.h"
 
+#if !defined(SOFTWARE_ONLY)
 // DirectX Headers
+#include "SDL_syswm.h"
 #include <dxgi.h>
 #include <d3d11.h>
 #include <d3dcompiler.h>
 #include <d3dx11effect.h>
+#endif
 
 // Framework Headers
 #include "Timer.h"